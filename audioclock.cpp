@@ -0,0 +1,73 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "audioclock.h"
+
+#include "audiocontroller.h"
+#include "audioring.h"
+
+void AudioClock::setSampleRate(int newSampleRate)
+{
+	sampleRate = newSampleRate;
+}
+
+int AudioClock::getSampleRate() const
+{
+	return sampleRate;
+}
+
+void AudioClock::start(const AudioController *newAudioController, const AudioRing *newAudioRing)
+{
+	audioController = newAudioController;
+	audioRing = newAudioRing;
+	startPosition = audioRing->readPosition();
+	audioUSecsAtStart = audioUSecs();
+	wallClock.restart();
+	haveReference = false;
+}
+
+int64_t AudioClock::audiblePosition()
+{
+	const int64_t wall_us = wallClock.nsecsElapsed() / 1000;
+	if (audioController == nullptr || !audioController->isActive()) {
+		return startPosition + framesFromUSecs(wall_us);
+	}
+
+	measureDrift(audioUSecs() - audioUSecsAtStart, wall_us);
+	return audioRing->readPosition() - audioController->queuedFrames();
+}
+
+double AudioClock::getDrift_ppm() const
+{
+	return drift_ppm;
+}
+
+int64_t AudioClock::audioUSecs() const
+{
+	return (audioController != nullptr) ? audioController->processedUSecs() : 0ll;
+}
+
+void AudioClock::measureDrift(int64_t audio_us, int64_t wall_us)
+{
+	// ignore start-up latency : measure from the first time the audio clock is seen to be moving
+	if (!haveReference) {
+		if (audio_us > 0) {
+			referenceAudio_us = audio_us;
+			referenceWall_us = wall_us;
+			haveReference = true;
+		}
+		return;
+	}
+
+	const int64_t elapsedWall_us = wall_us - referenceWall_us;
+	if (elapsedWall_us >= minDriftMeasurementTime_us) {
+		const int64_t elapsedAudio_us = audio_us - referenceAudio_us;
+		drift_ppm = 1.0e6 * (elapsedAudio_us - elapsedWall_us) / elapsedWall_us;
+	}
+}
@@ -0,0 +1,77 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef AUDIOCLOCK_H
+#define AUDIOCLOCK_H
+
+#include <QElapsedTimer>
+
+#include <cstdint>
+
+class AudioController;
+class AudioRing;
+
+// AudioClock : derives the playhead (the position, in the AudioRing's stream, of the frame currently being heard)
+// from how far the sound card has read into the AudioRing, less whatever it is still holding in its own buffer.
+// Falls back to the system clock when there is no audio output.
+// Drift is measured by comparing QAudioSink::processedUSecs() with the system clock.
+// All time <-> frame conversions use exact integer arithmetic (no rounding of frames-per-millisecond)
+
+class AudioClock
+{
+public:
+	void setSampleRate(int newSampleRate);
+	int getSampleRate() const;
+
+	// call whenever playback (re)starts
+	void start(const AudioController *newAudioController, const AudioRing *newAudioRing);
+
+	// stream position of frame currently being played
+	int64_t audiblePosition();
+
+	// measured rate difference between audio clock and system clock, in parts-per-million
+	double getDrift_ppm() const;
+
+	// conversions
+	int64_t framesFromUSecs(int64_t usecs) const
+	{
+		return usecs * sampleRate / 1000000;
+	}
+
+	int64_t framesFromMs(int64_t ms) const
+	{
+		return ms * sampleRate / 1000;
+	}
+
+	double msFromFrames(int64_t frames) const
+	{
+		return 1000.0 * frames / sampleRate;
+	}
+
+private:
+	static constexpr int64_t minDriftMeasurementTime_us = 1000000;
+
+	int sampleRate{44100};
+	int64_t startPosition{0ll};
+	const AudioController *audioController{nullptr};
+	const AudioRing *audioRing{nullptr};
+	QElapsedTimer wallClock;
+	int64_t audioUSecsAtStart{0ll};
+
+	// drift measurement reference point (taken once the audio clock starts moving)
+	bool haveReference{false};
+	int64_t referenceAudio_us{0ll};
+	int64_t referenceWall_us{0ll};
+	double drift_ppm{0.0};
+
+	int64_t audioUSecs() const;
+	void measureDrift(int64_t audio_us, int64_t wall_us);
+};
+
+#endif // AUDIOCLOCK_H
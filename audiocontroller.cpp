@@ -12,6 +12,8 @@
 #include <QDebug>
 #include <QMessageBox>
 
+#include <algorithm>
+
 AudioController::AudioController(QObject *parent)
 	: QObject(parent)
 {
@@ -40,7 +42,9 @@ void AudioController::initializeAudio(const QAudioFormat &format, const QAudioDe
 	audioOutput.reset(new QAudioSink(deviceInfo, format));
 	emit outputVolume(audioOutput->volume());
 
-	audioOutput->setBufferSize(2 * format.sampleRate() * format.bytesPerFrame());
+	// (pull mode) the sink only needs to buffer enough to ride out scheduling jitter
+	bytesPerFrame = format.bytesPerFrame();
+	audioOutput->setBufferSize(bufferDuration_ms * format.sampleRate() / 1000 * bytesPerFrame);
 
 	connect(audioOutput.get(), &QAudioSink::stateChanged, this, [this]{
 		qDebug().noquote() << "Audio Status:" << audioOutput->state();
@@ -55,12 +59,28 @@ void AudioController::setOutputVolume(qreal linearVolume)
 	}
 }
 
-QIODevice* AudioController::start()
+int AudioController::getBufferDuration_ms() const
+{
+	return bufferDuration_ms;
+}
+
+void AudioController::setBufferDuration_ms(int newBufferDuration_ms)
+{
+	// takes effect at next initializeAudio()
+	bufferDuration_ms = newBufferDuration_ms;
+}
+
+bool AudioController::start(QIODevice *source)
 {
+	if (audioOutput == nullptr) {
+		return false;
+	}
+
 	if (audioOutput->state() != QAudio::StoppedState) {
 		audioOutput->stop();
 	}
-	return audioOutput->start();
+	audioOutput->start(source);
+	return (audioOutput->error() == QAudio::NoError);
 }
 
 void AudioController::stop()
@@ -69,3 +89,25 @@ void AudioController::stop()
 		audioOutput->stop();
 	}
 }
+
+bool AudioController::isActive() const
+{
+	return audioOutput != nullptr
+			&& audioOutput->state() != QAudio::StoppedState
+			&& audioOutput->error() == QAudio::NoError;
+}
+
+qint64 AudioController::processedUSecs() const
+{
+	return (audioOutput != nullptr) ? audioOutput->processedUSecs() : 0ll;
+}
+
+int64_t AudioController::queuedFrames() const
+{
+	if (audioOutput == nullptr || bytesPerFrame == 0) {
+		return 0ll;
+	}
+
+	const qsizetype bufferSize = audioOutput->bufferSize();
+	return std::clamp<qsizetype>(bufferSize - audioOutput->bytesFree(), 0, bufferSize) / bytesPerFrame;
+}
@@ -24,14 +24,25 @@ public:
 	explicit AudioController(QObject *parent = nullptr);
 	void initializeAudio(const QAudioFormat &format, const QAudioDevice &deviceInfo);
 	void setOutputVolume(qreal linearVolume);
-	QIODevice *start();
+	int getBufferDuration_ms() const;
+	void setBufferDuration_ms(int newBufferDuration_ms);
+
+	// start playback, pulling audio from source
+	bool start(QIODevice *source);
 	void stop();
 
+	// sound card clock
+	bool isActive() const;
+	qint64 processedUSecs() const;
+	int64_t queuedFrames() const; // frames taken from source, but not yet played
+
 signals:
 	void outputVolume(qreal linearVol);
 
 private:
 	std::unique_ptr<QAudioSink> audioOutput;
+	int bufferDuration_ms{40};
+	int bytesPerFrame{0};
 };
 
 #endif // AUDIOCONTROLLER_H
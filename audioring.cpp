@@ -0,0 +1,105 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "audioring.h"
+
+#include <algorithm>
+
+void AudioRing::allocate(int newNumChannels, int64_t minCapacityFrames)
+{
+	numChannels = newNumChannels;
+	capacityFrames = 1;
+	while (capacityFrames < minCapacityFrames) {
+		capacityFrames <<= 1;
+	}
+
+	mask = capacityFrames - 1;
+	buffer.assign(capacityFrames * numChannels, 0.0f);
+
+	// positions carry on from where they were, so that stale positions held elsewhere never match new data
+	const int64_t t = tail.load(std::memory_order_relaxed);
+	head.store(t, std::memory_order_relaxed);
+	discardBefore.store(t, std::memory_order_relaxed);
+}
+
+int AudioRing::getNumChannels() const
+{
+	return numChannels;
+}
+
+int64_t AudioRing::getCapacityFrames() const
+{
+	return capacityFrames;
+}
+
+int64_t AudioRing::writePosition() const
+{
+	return tail.load(std::memory_order_relaxed);
+}
+
+int64_t AudioRing::freeFrames() const
+{
+	return capacityFrames - (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire));
+}
+
+int64_t AudioRing::write(const float *interleaved, int64_t frames)
+{
+	const int64_t t = tail.load(std::memory_order_relaxed);
+	frames = std::min(frames, freeFrames());
+
+	// copy in (up to) two pieces, either side of the wrap-around point
+	const int64_t first = std::min(frames, capacityFrames - (t & mask));
+	std::copy_n(interleaved, first * numChannels, buffer.data() + (t & mask) * numChannels);
+	std::copy_n(interleaved + first * numChannels, (frames - first) * numChannels, buffer.data());
+
+	tail.store(t + frames, std::memory_order_release);
+	return frames;
+}
+
+void AudioRing::discardQueued()
+{
+	discardBefore.store(tail.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+int64_t AudioRing::readPosition() const
+{
+	return head.load(std::memory_order_acquire);
+}
+
+int64_t AudioRing::availableFrames() const
+{
+	const int64_t h = skipStale(head.load(std::memory_order_relaxed));
+	return tail.load(std::memory_order_acquire) - h;
+}
+
+int64_t AudioRing::read(float *interleaved, int64_t frames)
+{
+	const int64_t h = skipStale(head.load(std::memory_order_relaxed));
+	frames = std::min(frames, tail.load(std::memory_order_acquire) - h);
+
+	const int64_t first = std::min(frames, capacityFrames - (h & mask));
+	std::copy_n(buffer.data() + (h & mask) * numChannels, first * numChannels, interleaved);
+	std::copy_n(buffer.data(), (frames - first) * numChannels, interleaved + first * numChannels);
+
+	head.store(h + frames, std::memory_order_release);
+	return frames;
+}
+
+int64_t AudioRing::skipTo(int64_t position)
+{
+	const int64_t h = skipStale(head.load(std::memory_order_relaxed));
+	const int64_t newHead = std::clamp(position, h, tail.load(std::memory_order_acquire));
+	head.store(newHead, std::memory_order_release);
+	return newHead - h;
+}
+
+int64_t AudioRing::skipStale(int64_t h) const
+{
+	return std::max(h, discardBefore.load(std::memory_order_acquire));
+}
@@ -0,0 +1,57 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef AUDIORING_H
+#define AUDIORING_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// AudioRing : lock-free single-producer / single-consumer FIFO of interleaved audio frames.
+// Read and write positions count frames from the start of the stream, and never go backwards,
+// so a position identifies a frame uniquely for the lifetime of the stream.
+// (The producer can use the write position to find out when a given frame will be read)
+// The producer may discard everything it has written so far (eg after a seek) with discardQueued() :
+// the consumer then skips straight to the new data on its next read.
+
+class AudioRing
+{
+public:
+	// allocate() may only be called while neither producer nor consumer is active
+	void allocate(int newNumChannels, int64_t minCapacityFrames);
+	int getNumChannels() const;
+	int64_t getCapacityFrames() const;
+
+	// producer
+	int64_t writePosition() const;
+	int64_t freeFrames() const;
+	int64_t write(const float *interleaved, int64_t frames);
+	void discardQueued();
+
+	// consumer
+	int64_t readPosition() const;
+	int64_t availableFrames() const;
+	int64_t read(float *interleaved, int64_t frames);
+	int64_t skipTo(int64_t position);
+
+private:
+	std::vector<float> buffer;
+	int numChannels{0};
+	int64_t capacityFrames{0ll}; // always a power of 2
+	int64_t mask{0ll};
+
+	alignas(64) std::atomic<int64_t> head{0ll}; // position of next frame to read (advanced by consumer)
+	alignas(64) std::atomic<int64_t> tail{0ll}; // position of next frame to write (advanced by producer)
+	std::atomic<int64_t> discardBefore{0ll}; // frames before this position are stale (set by producer)
+
+	int64_t skipStale(int64_t h) const;
+};
+
+#endif // AUDIORING_H
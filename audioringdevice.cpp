@@ -0,0 +1,60 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "audioringdevice.h"
+
+#include <algorithm>
+
+AudioRingDevice::AudioRingDevice(AudioRing *ring, QObject *parent)
+	: QIODevice{parent}, ring(ring)
+{
+	open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+bool AudioRingDevice::isSequential() const
+{
+	return true;
+}
+
+qint64 AudioRingDevice::bytesAvailable() const
+{
+	return ring->availableFrames() * ring->getNumChannels() * static_cast<qint64>(sizeof(float)) + QIODevice::bytesAvailable();
+}
+
+int64_t AudioRingDevice::getUnderrunFrames() const
+{
+	return underrunFrames.load(std::memory_order_relaxed);
+}
+
+qint64 AudioRingDevice::readData(char *data, qint64 maxlen)
+{
+	const int numChannels = ring->getNumChannels();
+	if (numChannels == 0) {
+		return 0;
+	}
+
+	const int64_t bytesPerFrame = numChannels * static_cast<int64_t>(sizeof(float));
+	const int64_t framesRequested = maxlen / bytesPerFrame;
+	float *out = reinterpret_cast<float *>(data);
+	const int64_t framesRead = ring->read(out, framesRequested);
+
+	if (framesRead < framesRequested) {
+		std::fill_n(out + framesRead * numChannels, (framesRequested - framesRead) * numChannels, 0.0f);
+		underrunFrames.fetch_add(framesRequested - framesRead, std::memory_order_relaxed);
+	}
+
+	return framesRequested * bytesPerFrame;
+}
+
+qint64 AudioRingDevice::writeData(const char *data, qint64 len)
+{
+	Q_UNUSED(data)
+	Q_UNUSED(len)
+	return -1;
+}
@@ -0,0 +1,45 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef AUDIORINGDEVICE_H
+#define AUDIORINGDEVICE_H
+
+#include "audioring.h"
+
+#include <QIODevice>
+
+#include <atomic>
+
+// AudioRingDevice : read-only QIODevice which lets a QAudioSink (in pull mode) take audio straight out of an AudioRing.
+// The sink pulls exactly as much as it needs, whenever it needs it.
+// If the ring runs dry, the shortfall is filled with silence (so that the sink never stalls)
+
+class AudioRingDevice : public QIODevice
+{
+	Q_OBJECT
+
+public:
+	explicit AudioRingDevice(AudioRing *ring, QObject *parent = nullptr);
+
+	bool isSequential() const override;
+	qint64 bytesAvailable() const override;
+
+	// number of frames of silence inserted because the ring was empty
+	int64_t getUnderrunFrames() const;
+
+protected:
+	qint64 readData(char *data, qint64 maxlen) override;
+	qint64 writeData(const char *data, qint64 len) override;
+
+private:
+	AudioRing *ring{nullptr};
+	std::atomic<int64_t> underrunFrames{0ll};
+};
+
+#endif // AUDIORINGDEVICE_H
@@ -17,10 +17,18 @@ AudioSettingsWidget::AudioSettingsWidget(QWidget *parent)
 	volumeSlider->setRange(0, 100);
 	volumeSlider->setValue(100);
 	volumeSlider->setTickInterval(10);
+	auto bufferDurationLabel = new QLabel("Buffer");
+	bufferDurationSpinBox = new QSpinBox;
+	bufferDurationSpinBox->setRange(10, 500);
+	bufferDurationSpinBox->setValue(40);
+	bufferDurationSpinBox->setSuffix(" ms");
+	bufferDurationSpinBox->setToolTip("Audio output buffer size (smaller = lower latency)");
 
 	auto outputDeviceLayout = new QVBoxLayout;
 	outputDeviceLayout->addWidget(deviceSelectorLabel);
 	outputDeviceLayout->addWidget(deviceSelector);
+	outputDeviceLayout->addWidget(bufferDurationLabel);
+	outputDeviceLayout->addWidget(bufferDurationSpinBox);
 	outputDeviceLayout->addStretch();
 
 	auto volumeLayout = new QVBoxLayout;
@@ -43,6 +51,10 @@ AudioSettingsWidget::AudioSettingsWidget(QWidget *parent)
 
 		emit outputVolumeChanged(QAudio::convertVolume (position / 100.0, QAudio::LogarithmicVolumeScale, QAudio::LinearVolumeScale));
 	});
+
+	connect(bufferDurationSpinBox, &QSpinBox::editingFinished, this, [this]{
+		emit bufferDurationChanged(bufferDurationSpinBox->value());
+	});
 }
 
 void AudioSettingsWidget::setAvailableOutputDevices(const QList<QAudioDevice> &deviceList)
@@ -69,3 +81,8 @@ QAudioDevice AudioSettingsWidget::getSelectedAudioDevice() const
 {
 	return deviceSelector->currentData().value<QAudioDevice>();
 }
+
+void AudioSettingsWidget::setBufferDuration_ms(int duration_ms)
+{
+	bufferDurationSpinBox->setValue(duration_ms);
+}
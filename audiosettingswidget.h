@@ -6,6 +6,7 @@
 #include <QMediaDevices>
 #include <QObject>
 #include <QSlider>
+#include <QSpinBox>
 #include <QWidget>
 
 class AudioSettingsWidget : public QWidget
@@ -16,15 +17,18 @@ public:
 	explicit AudioSettingsWidget(QWidget *parent = nullptr);
 	void setAvailableOutputDevices(const QList<QAudioDevice> &deviceList);
 	void setVolume(qreal linearVol);
+	void setBufferDuration_ms(int duration_ms);
 	QAudioDevice getSelectedAudioDevice() const;
 
 signals:
 	void outputDeviceSelected(const QAudioDevice &device);
 	void outputVolumeChanged(qreal linearVolume);
+	void bufferDurationChanged(int duration_ms);
 
 private:
 	QComboBox *deviceSelector{nullptr};
 	QSlider *volumeSlider;
+	QSpinBox *bufferDurationSpinBox{nullptr};
 };
 
 #endif // AUDIOSETTINGSWIDGET_H
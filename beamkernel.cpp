@@ -0,0 +1,121 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "beamkernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+BeamKernel::BeamKernel(double beamWidth)
+	: beamWidth{beamWidth}
+{
+	// FWHM = 2 * sqrt(2 * ln(2)) * sigma
+	constexpr double fwhmPerSigma = 2.3548200450309493;
+	constexpr double rsqrt2 = 0.70710678118654752;
+
+	sigma = std::max(beamWidth, 0.1) / fwhmPerSigma;
+	radius = static_cast<int>(std::ceil(3.0 * sigma)); // (beyond 3 sigma, less than 0.3% of the energy is lost)
+	size = 2 * radius + 2;
+
+	// 1-dimensional weights for each phase : Gaussian integrated across each pixel
+	std::vector<double> profile(static_cast<size_t>(subPixelPhases) * size);
+	double peak = 0.0;
+	for (int phase = 0; phase < subPixelPhases; phase++) {
+		const double centre = (phase + 0.5) / subPixelPhases; // (offset of beam from centre of pixel 'radius')
+		double *p = profile.data() + phase * size;
+		double sum = 0.0;
+		for (int j = 0; j < size; j++) {
+			const double d = (j - radius) - centre;
+			p[j] = 0.5 * (std::erf((d + 0.5) * rsqrt2 / sigma) - std::erf((d - 0.5) * rsqrt2 / sigma));
+			sum += p[j];
+		}
+		for (int j = 0; j < size; j++) {
+			p[j] /= sum; // (don't lose energy to truncation)
+			peak = std::max(peak, p[j]);
+		}
+	}
+	peak1D = static_cast<float>(peak);
+
+	// 2-dimensional kernels (the Gaussian is separable)
+	kernels.resize(static_cast<size_t>(subPixelPhases) * subPixelPhases * size * size);
+	for (int phaseY = 0; phaseY < subPixelPhases; phaseY++) {
+		for (int phaseX = 0; phaseX < subPixelPhases; phaseX++) {
+			float *k = kernels.data() + static_cast<size_t>(phaseY * subPixelPhases + phaseX) * size * size;
+			const double *py = profile.data() + phaseY * size;
+			const double *px = profile.data() + phaseX * size;
+			for (int y = 0; y < size; y++) {
+				for (int x = 0; x < size; x++) {
+					k[y * size + x] = static_cast<float>(py[y] * px[x]);
+				}
+			}
+		}
+	}
+}
+
+std::shared_ptr<const BeamKernel> BeamKernel::get(double beamWidth)
+{
+	struct CacheEntry
+	{
+		std::shared_ptr<const BeamKernel> kernel;
+		int64_t lastUsed;
+	};
+
+	static std::mutex mutex;
+	static std::map<int, CacheEntry> cache;
+	static int64_t useCount = 0ll;
+
+	const int key = static_cast<int>(std::lround(beamWidth * cacheResolution));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = cache.find(key);
+	if (it == cache.end()) {
+		// make room, by evicting the least recently used kernel
+		if (cache.size() >= maxCachedKernels) {
+			cache.erase(std::min_element(cache.begin(), cache.end(), [](const auto &a, const auto &b) {
+				return a.second.lastUsed < b.second.lastUsed;
+			}));
+		}
+		it = cache.emplace(key, CacheEntry{std::make_shared<const BeamKernel>(key / cacheResolution), 0ll}).first;
+	}
+
+	it->second.lastUsed = ++useCount;
+	return it->second.kernel;
+}
+
+double BeamKernel::getBeamWidth() const
+{
+	return beamWidth;
+}
+
+double BeamKernel::getSigma() const
+{
+	return sigma;
+}
+
+int BeamKernel::getRadius() const
+{
+	return radius;
+}
+
+int BeamKernel::getSize() const
+{
+	return size;
+}
+
+float BeamKernel::getPeak1D() const
+{
+	return peak1D;
+}
+
+const float *BeamKernel::weights(int phaseX, int phaseY) const
+{
+	return kernels.data() + static_cast<size_t>(phaseY * subPixelPhases + phaseX) * size * size;
+}
@@ -0,0 +1,56 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef BEAMKERNEL_H
+#define BEAMKERNEL_H
+
+#include <memory>
+#include <vector>
+
+// BeamKernel : precomputed splat kernels for a Gaussian beam spot of a given width (full width at half maximum).
+// The beam centre is quantised to one of subPixelPhases x subPixelPhases positions within a pixel,
+// and for each of those, the kernel holds the fraction of the beam's energy landing on each pixel
+// (the Gaussian integrated over the pixel's area, normalised to a total of 1).
+// Drawing a sample is then just a scaled add of a small square of weights.
+
+// Kernels are immutable once built, and are shared : get() builds (or reuses) one,
+// so that it can be done away from the render thread whenever the focus changes
+
+class BeamKernel
+{
+public:
+	static constexpr int subPixelPhases = 4;
+
+	explicit BeamKernel(double beamWidth);
+
+	// cached kernel for beamWidth (built if necessary)
+	static std::shared_ptr<const BeamKernel> get(double beamWidth);
+
+	double getBeamWidth() const;
+	double getSigma() const;
+	int getRadius() const;
+	int getSize() const;
+	float getPeak1D() const;
+
+	// size x size weights, for a beam centred in the given sub-pixel phase of pixel (radius, radius)
+	const float *weights(int phaseX, int phaseY) const;
+
+private:
+	static constexpr int maxCachedKernels = 16;
+	static constexpr double cacheResolution = 64.0; // (beam widths are cached to the nearest 1/64 pixel)
+
+	double beamWidth;
+	double sigma;
+	int radius; // (pixels either side of the centre pixel)
+	int size; // (an extra pixel, as phases reach beyond the centre pixel)
+	float peak1D; // highest weight of the 1-dimensional profile (ie intensity at the centre of a line of unit energy per pixel)
+	std::vector<float> kernels; // [phaseY][phaseX][y][x]
+};
+
+#endif // BEAMKERNEL_H
@@ -0,0 +1,533 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "beamrasteriser.h"
+
+#include "intensitydecay.h"
+#include "segmentlengths.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+BeamRasteriser::BeamRasteriser(int numWorkers)
+	: pool{numWorkers}
+{
+	bins.resize(pool.size());
+	setKernel(BeamKernel::get(1.0));
+	setLayers(Qt::black, {Layer{Qt::white, 0.9}});
+}
+
+void BeamRasteriser::resize(int newWidth, int newHeight)
+{
+	if (newWidth == w && newHeight == h) {
+		return;
+	}
+
+	w = newWidth;
+	h = newHeight;
+	for (Plane &plane : planes) {
+		plane.intensity.assign(static_cast<size_t>(w) * h, 0.0f);
+	}
+
+	tilesX = (w + tileSize - 1) / tileSize;
+	tilesY = (h + tileSize - 1) / tileSize;
+	const size_t numTiles = static_cast<size_t>(tilesX) * tilesY;
+	for (auto &chunkBins : bins) {
+		chunkBins.clear();
+		chunkBins.resize(numTiles);
+	}
+	tiles.assign(numTiles, Tile{});
+	invalidateTargets();
+}
+
+int BeamRasteriser::width() const
+{
+	return w;
+}
+
+int BeamRasteriser::height() const
+{
+	return h;
+}
+
+int BeamRasteriser::getNumWorkers() const
+{
+	return pool.size();
+}
+
+void BeamRasteriser::clear()
+{
+	for (Plane &plane : planes) {
+		std::fill(plane.intensity.begin(), plane.intensity.end(), 0.0f);
+	}
+	stamps.clear();
+	for (Tile &tile : tiles) {
+		tile.peak.fill(0.0f);
+	}
+}
+
+void BeamRasteriser::setLayers(const QColor &background, const QVector<Layer> &newLayers)
+{
+	backgroundColor = background;
+	layers = newLayers.isEmpty() ? QVector<Layer>{Layer{Qt::white, 0.9}} : newLayers.mid(0, maxLayers);
+	numLayers = static_cast<int>(layers.size());
+	allocatePlanes();
+}
+
+int BeamRasteriser::getNumLayers() const
+{
+	return numLayers;
+}
+
+void BeamRasteriser::setTraces(const QVector<QColor> &newTraceColors)
+{
+	traceColors = newTraceColors.isEmpty() ? QVector<QColor>{QColor{}} : newTraceColors.mid(0, maxTraces);
+	allocatePlanes();
+}
+
+int BeamRasteriser::getNumTraces() const
+{
+	return static_cast<int>(traceColors.size());
+}
+
+void BeamRasteriser::allocatePlanes()
+{
+	const size_t numPlanes = static_cast<size_t>(traceColors.size()) * numLayers;
+	if (numPlanes != planes.size()) {
+		planes.resize(numPlanes);
+		for (Plane &plane : planes) {
+			plane.intensity.assign(static_cast<size_t>(w) * h, 0.0f);
+		}
+		for (Tile &tile : tiles) {
+			tile.peak.fill(0.0f);
+		}
+	}
+
+	for (qsizetype t = 0; t < traceColors.size(); t++) {
+		const QColor &tint = traceColors.at(t);
+		for (int l = 0; l < numLayers; l++) {
+			Layer layer = layers.at(l);
+			if (tint.isValid()) {
+				layer.color = QColor::fromHsvF(tint.hsvHueF(), tint.hsvSaturationF(), layer.color.valueF());
+			}
+			planes[t * numLayers + l].layer = layer;
+		}
+	}
+	updateToneMaps();
+}
+
+void BeamRasteriser::setKernel(const std::shared_ptr<const BeamKernel> &newKernel)
+{
+	kernel = newKernel;
+}
+
+std::shared_ptr<const BeamKernel> BeamRasteriser::getKernel() const
+{
+	return kernel;
+}
+
+void BeamRasteriser::setVelocityModulation(bool enable)
+{
+	velocityModulation = enable;
+}
+
+bool BeamRasteriser::getVelocityModulation() const
+{
+	return velocityModulation;
+}
+
+double BeamRasteriser::getLineScale() const
+{
+	return kernel->getPeak1D();
+}
+
+void BeamRasteriser::addPoints(const QPointF *points, qsizetype count, float energy, int trace)
+{
+	stamps.reserve(stamps.size() + count);
+	for (qsizetype i = 0; i < count; i++) {
+		stamps.push_back({static_cast<float>(points[i].x()), static_cast<float>(points[i].y()), energy, trace});
+	}
+}
+
+void BeamRasteriser::addLines(const QPointF *points, qsizetype count, float energy, int trace)
+{
+	addLines(points, count, energy, trace, nullptr);
+}
+
+// clip the line p0 + t * (p1 - p0), 0 <= t <= 1 to a rectangle (Liang-Barsky), returning false if it misses it
+static bool clipLine(const QPointF &p0, const QPointF &p1, double left, double top, double right, double bottom, float &t0, float &t1)
+{
+	const double dx = p1.x() - p0.x();
+	const double dy = p1.y() - p0.y();
+	const double p[4] = {-dx, dx, -dy, dy};
+	const double q[4] = {p0.x() - left, right - p0.x(), p0.y() - top, bottom - p0.y()};
+	double lo = 0.0;
+	double hi = 1.0;
+	for (int k = 0; k < 4; k++) {
+		if (p[k] == 0.0) {
+			if (q[k] < 0.0) {
+				return false; // (parallel to, and outside, this edge)
+			}
+		} else {
+			const double r = q[k] / p[k];
+			if (p[k] < 0.0) {
+				lo = std::max(lo, r);
+			} else {
+				hi = std::min(hi, r);
+			}
+		}
+	}
+	t0 = static_cast<float>(lo);
+	t1 = static_cast<float>(hi);
+	return lo <= hi;
+}
+
+void BeamRasteriser::addLines(const QPointF *points, qsizetype count, float energy, int trace, const float *weights)
+{
+	// stamp the beam every sigma along each line (which is smooth enough for a Gaussian spot),
+	// but no finer than the kernel's sub-pixel resolution, and no coarser than a pixel.
+	const double maxSpacing = std::clamp(kernel->getSigma(), 1.0 / BeamKernel::subPixelPhases, 1.0);
+	const double lineScale = kernel->getPeak1D();
+
+	const qsizetype numSegments = count / 2;
+	segmentLengths.resize(numSegments);
+	segmentSteps.resize(numSegments);
+	segmentClip.resize(numSegments);
+	SegmentLengths::measure(points, numSegments, segmentLengths.data());
+
+	// only the part of each line within reach of the screen (the kernel's radius beyond its edges) is stamped
+	const double margin = kernel->getRadius() + 1;
+	const double left = -margin;
+	const double top = -margin;
+	const double right = w + margin;
+	const double bottom = h + margin;
+
+	// with velocity modulation (or weights), a segment's centre intensity is energy * weight * lineScale / length :
+	// segments too long for that to survive the next decay (see minIntensity) aren't worth drawing
+	const bool shared = velocityModulation || (weights != nullptr);
+	const double maxLength = shared ? energy * lineScale / minIntensity : std::numeric_limits<double>::max();
+
+	size_t numStamps = 0;
+	for (qsizetype i = 0; i < numSegments; i++) {
+		const double length = segmentLengths[i];
+		const double weight = (weights != nullptr) ? weights[i] : 1.0;
+		std::array<float, 2> &clip = segmentClip[i];
+		const bool visible = clipLine(points[2 * i], points[2 * i + 1], left, top, right, bottom, clip[0], clip[1]);
+		const double visibleLength = length * (clip[1] - clip[0]);
+		const int steps = (!visible || length > maxLength * weight) ? 0 : std::max(1, static_cast<int>(std::ceil(visibleLength / maxSpacing)));
+		segmentSteps[i] = steps;
+		numStamps += steps;
+	}
+
+	const size_t first = stamps.size();
+	stamps.resize(first + numStamps);
+	Stamp *stamp = stamps.data() + first;
+
+	for (qsizetype i = 0; i < numSegments; i++) {
+		const int steps = segmentSteps[i];
+		if (steps == 0) {
+			continue;
+		}
+
+		// velocity modulation : each segment gets the energy of one sample (or weighted line : of weight samples),
+		// shared along its whole length (so the visible part gets its share of it). Otherwise, the line has (1 / spacing) stamps
+		// per pixel of length, so each stamp deposits a corresponding fraction of the energy that gives the line the same
+		// centre brightness as a point
+		const std::array<float, 2> &clip = segmentClip[i];
+		const double visibleFraction = clip[1] - clip[0];
+		const double length = segmentLengths[i] * visibleFraction;
+		const double spacing = (length > 0.0) ? length / steps : maxSpacing;
+		const float lineEnergy = (weights != nullptr) ? energy * weights[i] : energy;
+		const float stampEnergy = shared ? lineEnergy * static_cast<float>(visibleFraction) / steps : lineEnergy * static_cast<float>(spacing * lineScale);
+
+		// (last point of each line is left for the next one)
+		const QPointF &p0 = points[2 * i];
+		const QPointF &p1 = points[2 * i + 1];
+		const double dx = p1.x() - p0.x();
+		const double dy = p1.y() - p0.y();
+		for (int s = 0; s < steps; s++) {
+			const double t = clip[0] + visibleFraction * s / steps;
+			*stamp++ = {static_cast<float>(p0.x() + t * dx), static_cast<float>(p0.y() + t * dy), stampEnergy, trace};
+		}
+	}
+}
+
+void BeamRasteriser::render(QImage *target, int elapsedFrames)
+{
+	if (w == 0 || h == 0) {
+		stamps.clear();
+		return;
+	}
+
+	// sort stamps into per-tile bins : one chunk of stamps (and one set of bins) per worker
+	const int numChunks = static_cast<int>(bins.size());
+	pool.run(numChunks, [this, numChunks](int chunk, int) {
+		binStamps(chunk, numChunks);
+	});
+	stamps.clear();
+
+	// draw tiles
+	frame += elapsedFrames;
+	std::vector<uint8_t> &clean = targetState(target).clean;
+	uchar *bits = target->bits();
+	const qsizetype bytesPerLine = target->bytesPerLine();
+	pool.run(tilesX * tilesY, [this, bits, bytesPerLine, &clean](int tile, int) {
+		renderTile(tile, bits, bytesPerLine, clean);
+	});
+}
+
+inline BeamRasteriser::Placement BeamRasteriser::place(const Stamp &stamp) const
+{
+	// pixel (px, py) has its centre at (px + 0.5, py + 0.5)
+	constexpr int phases = BeamKernel::subPixelPhases;
+	const float u = stamp.x - 0.5f;
+	const float v = stamp.y - 0.5f;
+	const float ix = std::floor(u);
+	const float iy = std::floor(v);
+	const int phaseX = std::min(phases - 1, static_cast<int>((u - ix) * phases));
+	const int phaseY = std::min(phases - 1, static_cast<int>((v - iy) * phases));
+	const int radius = kernel->getRadius();
+	return {
+		static_cast<int>(ix) - radius,
+		static_cast<int>(iy) - radius,
+		kernel->weights(phaseX, phaseY)
+	};
+}
+
+inline BeamRasteriser::PixelRange BeamRasteriser::footprint(const Stamp &stamp) const
+{
+	const Placement p = place(stamp);
+	const int size = kernel->getSize();
+	return {
+		std::max(0, p.x0),
+		std::max(0, p.y0),
+		std::min(w - 1, p.x0 + size - 1),
+		std::min(h - 1, p.y0 + size - 1)
+	};
+}
+
+void BeamRasteriser::binStamps(int chunk, int numChunks)
+{
+	auto &chunkBins = bins[chunk];
+	const size_t begin = stamps.size() * chunk / numChunks;
+	const size_t end = stamps.size() * (chunk + 1) / numChunks;
+
+	for (size_t i = begin; i < end; i++) {
+		const Stamp &stamp = stamps[i];
+		const PixelRange r = footprint(stamp);
+		if (r.x0 > r.x1 || r.y0 > r.y1) {
+			continue; // off-screen
+		}
+
+		// (a stamp straddling a tile boundary goes into each tile it touches)
+		for (int ty = r.y0 / tileSize; ty <= r.y1 / tileSize; ty++) {
+			for (int tx = r.x0 / tileSize; tx <= r.x1 / tileSize; tx++) {
+				chunkBins[ty * tilesX + tx].push_back(stamp);
+			}
+		}
+	}
+}
+
+BeamRasteriser::TargetState &BeamRasteriser::targetState(const QImage *target)
+{
+	const uchar *bits = target->constBits();
+	for (TargetState &t : targets) {
+		if (t.bits == bits) {
+			return t;
+		}
+	}
+
+	// new target : assume it holds nothing useful
+	TargetState &t = targets[nextTarget];
+	nextTarget = (nextTarget + 1) % maxTargets;
+	t.bits = bits;
+	t.clean.assign(tiles.size(), 0);
+	return t;
+}
+
+void BeamRasteriser::invalidate(const QImage *target)
+{
+	const uchar *bits = target->constBits();
+	for (TargetState &t : targets) {
+		if (t.bits == bits) {
+			std::fill(t.clean.begin(), t.clean.end(), 0);
+		}
+	}
+}
+
+void BeamRasteriser::invalidateTargets()
+{
+	for (TargetState &t : targets) {
+		t.bits = nullptr;
+		t.clean.clear();
+	}
+}
+
+// add channels of a and b, saturating at 255 (result is opaque)
+static inline QRgb addSaturate(QRgb a, QRgb b)
+{
+	uint32_t rb = (a & 0x00ff00ffu) + (b & 0x00ff00ffu);
+	uint32_t g = (a & 0x0000ff00u) + (b & 0x0000ff00u);
+	rb |= (rb & 0x01000100u) - ((rb & 0x01000100u) >> 8); // (overflow bit -> all ones in that channel)
+	g |= (g & 0x00010000u) - ((g & 0x00010000u) >> 8);
+	return 0xff000000u | (rb & 0x00ff00ffu) | (g & 0x0000ff00u);
+}
+
+void BeamRasteriser::renderTile(int tile, uchar *targetBits, qsizetype bytesPerLine, std::vector<uint8_t> &clean)
+{
+	Tile &t = tiles[tile];
+	bool drawnOn = false;
+	for (const auto &chunkBins : bins) {
+		drawnOn = drawnOn || !chunkBins[tile].empty();
+	}
+
+	const int tx = tile % tilesX;
+	const int ty = tile / tilesX;
+	const PixelRange clip {
+		tx * tileSize,
+		ty * tileSize,
+		std::min(w, (tx + 1) * tileSize) - 1,
+		std::min(h, (ty + 1) * tileSize) - 1
+	};
+	const size_t clipWidth = static_cast<size_t>(clip.x1 - clip.x0 + 1);
+
+	// faded-out tile : only needs painting with background (once per target)
+	if (t.isEmpty() && !drawnOn) {
+		if (!clean[tile]) {
+			const QRgb background = planes[0].toneMapTable[0];
+			for (int py = clip.y0; py <= clip.y1; py++) {
+				QRgb *out = reinterpret_cast<QRgb *>(targetBits + py * bytesPerLine);
+				std::fill(out + clip.x0, out + clip.x1 + 1, background);
+			}
+			clean[tile] = 1;
+		}
+		t.decayedAt = frame;
+		return;
+	}
+
+	// catch up on decay (and note which planes have anything in them)
+	const int numPlanes = static_cast<int>(planes.size());
+	std::array<float *, maxPlanes> data{};
+	uint32_t active = 0u;
+	for (int l = 0; l < numPlanes; l++) {
+		data[l] = planes[l].intensity.data();
+		if (t.peak[l] == 0.0f) {
+			continue;
+		}
+
+		if (frame == t.decayedAt) {
+			active |= (1u << l);
+			continue;
+		}
+
+		const float decayFactor = static_cast<float>(std::pow(planes[l].layer.decay, static_cast<double>(frame - t.decayedAt)));
+		const bool fadedOut = (t.peak[l] * decayFactor < minIntensity);
+		if (!fadedOut) {
+			active |= (1u << l);
+		}
+		for (int py = clip.y0; py <= clip.y1; py++) {
+			float *row = data[l] + static_cast<size_t>(py) * w + clip.x0;
+			if (fadedOut) {
+				std::fill(row, row + clipWidth, 0.0f);
+			} else {
+				IntensityDecay::apply(row, clipWidth, decayFactor, minIntensity);
+			}
+		}
+	}
+	t.decayedAt = frame;
+
+	// draw (chunks in order, so that the result doesn't depend on which worker did what)
+	const uint32_t traceMask = (1u << numLayers) - 1u;
+	for (auto &chunkBins : bins) {
+		auto &bin = chunkBins[tile];
+		for (const Stamp &stamp : bin) {
+			splat(stamp, clip, data.data());
+			active |= traceMask << (stamp.trace * numLayers);
+		}
+		bin.clear();
+	}
+
+	// tone-map and composite (and find new peaks), skipping empty planes
+	const float scale = (toneMapSize - 1) / toneMapRange;
+	auto lookup = [scale](const Plane &plane, float v) {
+		return plane.toneMapTable[static_cast<int>(std::min(v * scale, static_cast<float>(toneMapSize - 1)))];
+	};
+
+	std::array<float, maxPlanes> peak{};
+	for (int py = clip.y0; py <= clip.y1; py++) {
+		const size_t offset = static_cast<size_t>(py) * w;
+		QRgb *out = reinterpret_cast<QRgb *>(targetBits + py * bytesPerLine);
+		const float *in0 = data[0] + offset;
+		if (active & 1u) {
+			for (int px = clip.x0; px <= clip.x1; px++) {
+				peak[0] = std::max(peak[0], in0[px]);
+				out[px] = lookup(planes[0], in0[px]);
+			}
+		} else {
+			std::fill(out + clip.x0, out + clip.x1 + 1, planes[0].toneMapTable[0]);
+		}
+		for (int l = 1; l < numPlanes; l++) {
+			if ((active & (1u << l)) == 0u) {
+				continue;
+			}
+			const float *in = data[l] + offset;
+			for (int px = clip.x0; px <= clip.x1; px++) {
+				peak[l] = std::max(peak[l], in[px]);
+				out[px] = addSaturate(out[px], lookup(planes[l], in[px]));
+			}
+		}
+	}
+	t.peak = peak;
+	clean[tile] = t.isEmpty();
+}
+
+inline void BeamRasteriser::splat(const Stamp &stamp, const PixelRange &clip, float *const *data)
+{
+	const Placement p = place(stamp);
+	const int size = kernel->getSize();
+	const int x0 = std::max(p.x0, clip.x0);
+	const int x1 = std::min(p.x0 + size - 1, clip.x1);
+	const int y0 = std::max(p.y0, clip.y0);
+	const int y1 = std::min(p.y0 + size - 1, clip.y1);
+	float *const *traceData = data + stamp.trace * numLayers;
+
+	for (int py = y0; py <= y1; py++) {
+		const float *weights = p.weights + (py - p.y0) * size + (x0 - p.x0);
+		const size_t offset = static_cast<size_t>(py) * w + x0;
+		for (int l = 0; l < numLayers; l++) {
+			float *row = traceData[l] + offset;
+			for (int i = 0; i <= x1 - x0; i++) {
+				row[i] += stamp.energy * weights[i];
+			}
+		}
+	}
+}
+
+void BeamRasteriser::updateToneMaps()
+{
+	// brightness : 1 - exp(-intensity), which is linear for faint traces, and saturates smoothly.
+	// The first plane (first trace, first layer) blends from the background to its colour; the others only contribute their own light
+	invalidateTargets();
+
+	const double scale = toneMapRange / (toneMapSize - 1);
+	for (size_t l = 0; l < planes.size(); l++) {
+		const QColor &c = planes[l].layer.color;
+		const QColor base = (l == 0) ? backgroundColor : QColor{Qt::black};
+		for (int i = 0; i < toneMapSize; i++) {
+			const double b = 1.0 - std::exp(-i * scale);
+			auto channel = [b](int bg, int ph) {
+				return static_cast<int>(std::lround(bg + b * (ph - bg)));
+			};
+			planes[l].toneMapTable[i] = qRgb(channel(base.red(), c.red()),
+											 channel(base.green(), c.green()),
+											 channel(base.blue(), c.blue()));
+		}
+	}
+}
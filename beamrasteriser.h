@@ -0,0 +1,204 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef BEAMRASTERISER_H
+#define BEAMRASTERISER_H
+
+#include "beamkernel.h"
+#include "workerpool.h"
+
+#include <QColor>
+#include <QImage>
+#include <QPointF>
+#include <QVector>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// BeamRasteriser : accumulates beam energy into floating-point intensity buffers (one float per pixel),
+// which are only converted to colour (tone-mapped) when a frame is published.
+// Since intensities are never clamped, dense regions (eg Lissajous figures) keep building up,
+// and the tone-mapping curve makes them saturate gradually, rather than clipping at 8 bits.
+// The beam spot is Gaussian (see BeamKernel); a point deposits the given energy, spread over the spot.
+// A line deposits the same energy as a point, spread along its length : the beam spends the same time
+// on every segment, so fast-moving parts of the trace are dim and slow-moving ones are bright (velocity modulation).
+// Without velocity modulation, a line is as bright along its centre as a point is at its centre.
+
+// Each phosphor layer has its own intensity plane, colour and decay rate. Every plane receives the same energy,
+// and the layers are composited when tone-mapping : the first layer over the background, and the others added to it.
+// (eg a short-lived bright layer with a long-lived dim layer gives a P7-style long tail)
+
+// Several traces (eg one per channel) can be drawn at once, each in its own colour : every trace has its own set
+// of layer planes, tinted with the trace's colour, so that traces which cross each other don't mix.
+
+// Drawing is deferred : points and lines are collected as beam "stamps", and render() does the work in parallel.
+// The screen is divided into tiles, and the stamps are first sorted into per-tile bins
+// (each worker bins its own share of the stamps, into its own set of bins), and then each tile is
+// decayed, drawn and tone-mapped by whichever worker claims it. A tile only ever writes to its own pixels,
+// so the workers never need to synchronise with each other.
+
+// Persistence is lazy : each tile remembers the frame it was last decayed at, and the peak intensity it held then,
+// and catches up on all the decay it has missed (decay ^ elapsed frames) the next time it is visited.
+// Once a tile has faded out completely, it is left alone (no decay, no tone-mapping) until it is drawn on again,
+// apart from being painted with the background colour once in each of the images it is rendered into.
+// So the cost of persistence is proportional to the area covered by the trace, rather than to the screen size
+
+class BeamRasteriser
+{
+public:
+	static constexpr int tileSize = 64;
+	static constexpr int maxLayers = 4;
+	static constexpr int maxTraces = 8;
+	static constexpr int maxPlanes = maxLayers * maxTraces;
+
+	struct Layer
+	{
+		QColor color;
+		double decay; // fraction of intensity remaining after each frame
+	};
+
+	explicit BeamRasteriser(int numWorkers = 0); // (0 : one worker per hardware thread)
+
+	void resize(int newWidth, int newHeight); // (clears, if size changes)
+	int width() const;
+	int height() const;
+	int getNumWorkers() const;
+
+	void clear();
+
+	// phosphor (up to maxLayers layers; changing the number of layers clears the screen)
+	void setLayers(const QColor &background, const QVector<Layer> &newLayers);
+	int getNumLayers() const;
+
+	// traces (up to maxTraces; changing the number of traces clears the screen).
+	// A trace takes the hue and saturation of its colour, and the brightness of each layer.
+	// (an invalid colour : the layers' own colours)
+	void setTraces(const QVector<QColor> &newTraceColors);
+	int getNumTraces() const;
+
+	// beam
+	void setKernel(const std::shared_ptr<const BeamKernel> &newKernel);
+	std::shared_ptr<const BeamKernel> getKernel() const;
+	void setVelocityModulation(bool enable);
+	bool getVelocityModulation() const;
+	double getLineScale() const; // (without velocity modulation : a line's energy per pixel of length, relative to a point's)
+
+	// drawing
+	void addPoints(const QPointF *points, qsizetype count, float energy, int trace = 0);
+	void addLines(const QPointF *points, qsizetype count, float energy, int trace = 0); // (points are taken in pairs)
+	// (as above, but each line gets weight times the energy of a point, spread along it whatever the velocity modulation :
+	// eg a span standing in for several samples)
+	void addLines(const QPointF *points, qsizetype count, float energy, int trace, const float *weights);
+
+	// advance time by elapsedFrames, draw everything added since the last render, and tone-map into target
+	// (target must be ARGB32 (premultiplied or not) and the same size)
+	void render(QImage *target, int elapsedFrames = 1);
+
+	// forget which tiles of target hold nothing but background (call after drawing anything else into it)
+	void invalidate(const QImage *target);
+
+private:
+	static constexpr int toneMapSize = 4096;
+	static constexpr float toneMapRange = 8.0f; // intensities beyond this are fully saturated
+	static constexpr float minIntensity = 1.0e-4f; // (decayed intensities below this are flushed to zero)
+
+	struct Stamp
+	{
+		float x;
+		float y;
+		float energy;
+		int trace;
+	};
+
+	struct Tile
+	{
+		int64_t decayedAt{0ll}; // frame when decay was last applied
+		std::array<float, maxPlanes> peak{}; // highest intensity in the tile (per plane) at that time (0 : plane is empty)
+
+		bool isEmpty() const
+		{
+			for (float p : peak) {
+				if (p != 0.0f) {
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+
+	// planes are grouped by trace : [trace * numLayers + layer]
+	struct Plane
+	{
+		Layer layer; // (colour tinted for the trace)
+		std::vector<float> intensity;
+		std::array<QRgb, toneMapSize> toneMapTable;
+	};
+
+	// render targets are remembered, along with the tiles they hold nothing but background for
+	struct TargetState
+	{
+		const uchar *bits{nullptr};
+		std::vector<uint8_t> clean; // per tile
+	};
+
+	static constexpr int maxTargets = 3;
+
+	struct PixelRange
+	{
+		int x0;
+		int y0;
+		int x1; // (inclusive)
+		int y1; // (inclusive)
+	};
+
+	int w{0};
+	int h{0};
+	int tilesX{0};
+	int tilesY{0};
+	QColor backgroundColor{Qt::black};
+	QVector<Layer> layers;
+	QVector<QColor> traceColors{QColor{}};
+	int numLayers{0};
+	std::vector<Plane> planes;
+	std::vector<Tile> tiles;
+	std::array<TargetState, maxTargets> targets;
+	int nextTarget{0}; // (next TargetState to be recycled)
+	int64_t frame{0ll};
+
+	std::shared_ptr<const BeamKernel> kernel;
+	bool velocityModulation{true};
+
+	WorkerPool pool;
+	std::vector<Stamp> stamps;
+	std::vector<float> segmentLengths; // (scratch, for addLines())
+	std::vector<int> segmentSteps; // (ditto)
+	std::vector<std::array<float, 2>> segmentClip; // (ditto) visible part of each segment, as fractions of its length
+	std::vector<std::vector<std::vector<Stamp>>> bins; // [chunk][tile]
+
+	// where a stamp's kernel lands : top-left pixel, and weights for its sub-pixel phase
+	struct Placement
+	{
+		int x0;
+		int y0;
+		const float *weights;
+	};
+
+	Placement place(const Stamp &stamp) const;
+	PixelRange footprint(const Stamp &stamp) const;
+	void binStamps(int chunk, int numChunks);
+	TargetState &targetState(const QImage *target);
+	void invalidateTargets();
+	void renderTile(int tile, uchar *targetBits, qsizetype bytesPerLine, std::vector<uint8_t> &clean);
+	void splat(const Stamp &stamp, const PixelRange &clip, float *const *data);
+	void allocatePlanes();
+	void updateToneMaps();
+};
+
+#endif // BEAMRASTERISER_H
@@ -0,0 +1,263 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+// plotterbench : times the Plotter's point generation kernels (one per plot mode, mono / stereo, points / lines),
+// in ns per input frame, against the per-sample loop they replaced. Build with bench/plotterbench.pro
+// (not part of the application build)
+
+#include "frameswapchain.h"
+#include "plotter.h"
+#include "sampleblock.h"
+
+#include <QCoreApplication>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// BenchPlotter : runs the plot kernels directly, one block at a time
+class BenchPlotter : public Plotter
+{
+public:
+	void plot(Plotmode mode, bool stereo, bool lines, bool envelope, const SampleBlock *block)
+	{
+		(this->*selectPlotFunction(mode, stereo, lines, envelope))(block, 0ll);
+		clearPlotBuffers();
+	}
+};
+
+// Baseline : the point generation which the kernels replaced, for comparison : a single loop, which switches on
+// the plot mode (and tests the channel count and line drawing) for every sample.
+// (Sweep only ever plotted the first channel, and triggered on a level window and a differentiator's slope :
+// here, with the default trigger settings)
+class Baseline
+{
+public:
+	Baseline(qreal width, qreal height) : cx{width / 2.0}, cy{height / 2.0}, w{width}
+	{
+	}
+
+	void plot(Plotmode plotMode, int numInputChannels, bool drawLines, qreal sweepAdvance, const SampleBlock *block)
+	{
+		const float *in0 = block->channel(0);
+		const float *in1 = block->channel(numInputChannels > 1 ? 1 : 0);
+
+		for (int64_t i = 0; i < block->frames; i++) {
+			double ch0val = static_cast<double>(in0[i]);
+			double ch1val = (numInputChannels > 1 ? static_cast<double>(in1[i]) : 0.0);
+
+			switch (plotMode) {
+			case XY:
+			default:
+			{
+				QPointF pt{(1.0 + ch0val) * cx, (1.0 - ch1val) * cy};
+				if (drawLines) {
+					plotBuffer.append(lastPoint);
+				}
+				plotBuffer.append(pt);
+				lastPoint = pt;
+			}
+				break;
+			case MidSide:
+			{
+				static constexpr double rsqrt2 = 0.707;
+				QPointF pt{(1.0 + rsqrt2 * (ch0val - ch1val)) * cx,
+							(1.0 - rsqrt2 * (ch0val + ch1val)) * cy};
+				if (drawLines) {
+					plotBuffer.append(lastPoint);
+				}
+				plotBuffer.append(pt);
+				lastPoint = pt;
+			}
+				break;
+			case Sweep:
+			{
+				const double &source = ch0val;
+				double slope = differentiate(source) * triggerSlope;
+				double delayed = delay(source);
+
+				triggered = triggered
+							|| !triggerEnabled
+							|| (triggerMin <= delayed && delayed <= triggerMax && slope > 0.0);
+
+				if (triggered) {
+					QPointF pt{x, cy * (1.0 - delayed)};
+					if (drawLines)  {
+						plotBuffer.append(lastPoint);
+					}
+					lastPoint = pt;
+					plotBuffer.append(pt);
+					x += sweepAdvance;
+					if (x > w) {
+						x = 0.0;
+						triggered = false;
+						lastPoint = {x, cy * (1.0 - triggerLevel)};
+					}
+				}
+			}
+				break;
+			}
+		}
+		plotBuffer.clear();
+	}
+
+private:
+	static constexpr std::array<double, 11> differentiatorCoeffs {
+		0.0209, 0.0, -0.1128, 0.0, 1.2411, 0.0, -1.2411, 0.0, 0.1128, 0.0, -0.0209
+	};
+	static constexpr size_t delayTime = (differentiatorCoeffs.size() - 1) / 2;
+	static constexpr bool triggerEnabled = true;
+	static constexpr double triggerLevel = 0.0;
+	static constexpr double triggerMin = triggerLevel - 0.01;
+	static constexpr double triggerMax = triggerLevel + 0.01;
+	static constexpr double triggerSlope = 1.0;
+
+	qreal cx;
+	qreal cy;
+	qreal w;
+	QVector<QPointF> plotBuffer;
+	QPointF lastPoint;
+	bool triggered{false};
+	qreal x{0.0};
+	std::array<double, differentiatorCoeffs.size()> differentiatorHistory{};
+	size_t differentiatorIndex{differentiatorCoeffs.size() - 1};
+	std::array<double, delayTime> delayHistory{};
+	size_t delayIndex{0};
+
+	double differentiate(double input)
+	{
+		differentiatorHistory[differentiatorIndex] = input;
+		double dP{0.0};
+		size_t p = differentiatorIndex;
+		for (size_t j = 0 ; j < differentiatorCoeffs.size(); j++) {
+			dP += differentiatorCoeffs[j] * differentiatorHistory.at(p);
+			if (++p == differentiatorCoeffs.size()) {
+				p = 0;
+			}
+		}
+		differentiatorIndex = (differentiatorIndex == 0) ? differentiatorCoeffs.size() - 1 : differentiatorIndex - 1;
+		return dP;
+	}
+
+	double delay(double input)
+	{
+		const double output = delayHistory[delayIndex];
+		delayHistory[delayIndex] = input;
+		if (++delayIndex == delayHistory.size()) {
+			delayIndex = 0;
+		}
+		return output;
+	}
+};
+
+class PlotterBench
+{
+public:
+	static constexpr int width = 1920;
+	static constexpr int height = 1080;
+	static constexpr int numBlocks = 16;
+	static constexpr int64_t blockFrames = 3200; // (one frame's worth of 4x upsampled 48kHz audio, at 60 fps)
+	static constexpr int repeats = 200;
+
+	PlotterBench() : baseline{width, height}
+	{
+		swapChain.resize(QSize{width, height}, Qt::black);
+		plotter.setSwapChain(&swapChain);
+		plotter.setAudioFramesPerMs(48.0 * 4);
+
+		// something like music : a few tones, plus noise
+		constexpr double twoPi = 2.0 * 3.14159265358979323846;
+		std::mt19937 rng{1234};
+		std::normal_distribution<float> noise{0.0f, 0.05f};
+		pool.allocate(numBlocks, 2, blockFrames);
+		int64_t frame = 0ll;
+		for (int b = 0; b < numBlocks; b++) {
+			blocks.push_back(pool.acquire());
+			SampleBlock *block = blocks.back().get();
+			block->startFrame = frame;
+			block->frames = blockFrames;
+			for (int64_t i = 0; i < blockFrames; i++, frame++) {
+				const double t = frame / (48000.0 * 4);
+				block->channel(0)[i] = static_cast<float>(0.5 * std::sin(twoPi * 440 * t) + 0.2 * std::sin(twoPi * 1375 * t)) + noise(rng);
+				block->channel(1)[i] = static_cast<float>(0.5 * std::cos(twoPi * 440 * t) + 0.2 * std::sin(twoPi * 2200 * t)) + noise(rng);
+			}
+		}
+	}
+
+	// ns per input frame, for the kernel (or the baseline loop)
+	double run(Plotmode mode, bool stereo, bool lines, bool envelope = false, bool useBaseline = false)
+	{
+		plotter.setNumInputChannels(stereo ? 2 : 1);
+		plotter.setPlotMode(mode);
+		SweepParameters sweepParameters = plotter.getSweepParameters();
+		sweepParameters.setDuration_ms(envelope ? 1000.0 : 10.0);
+		plotter.setSweepParameters(sweepParameters);
+		const qreal sweepAdvance = static_cast<qreal>(width) / plotter.getSweepParameters().framesFor_ms(sweepParameters.getDuration_ms());
+
+		const auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++) {
+			for (const SampleBlockPtr &block : blocks) {
+				if (useBaseline) {
+					baseline.plot(mode, stereo ? 2 : 1, lines, sweepAdvance, block.get());
+				} else {
+					plotter.plot(mode, stereo, lines, envelope, block.get());
+				}
+			}
+		}
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / (static_cast<double>(repeats) * numBlocks * blockFrames);
+	}
+
+private:
+	FrameSwapChain swapChain;
+	BenchPlotter plotter;
+	Baseline baseline;
+	SampleBlockPool pool;
+	std::vector<SampleBlockPtr> blocks;
+};
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	PlotterBench bench;
+
+	// (one warm-up pass each, so that the plot buffers have reached full size)
+	bench.run(XY, true, true);
+	bench.run(XY, true, true, false, true);
+
+	const struct {
+		Plotmode mode;
+		const char *name;
+	} modes[] {
+		{XY, "XY"},
+		{MidSide, "MidSide"},
+		{Sweep, "Sweep"}
+	};
+
+	std::printf("ns per input frame (%lld-frame blocks) : before (per-sample switch) -> after (kernel)\n",
+				static_cast<long long>(PlotterBench::blockFrames));
+	std::printf("%-10s %16s %16s %16s %16s\n", "", "mono points", "mono lines", "stereo points", "stereo lines");
+	for (const auto &m : modes) {
+		std::printf("%-10s", m.name);
+		for (const bool stereo : {false, true}) {
+			for (const bool lines : {false, true}) {
+				std::printf(" %7.2f -> %5.2f", bench.run(m.mode, stereo, lines, false, true), bench.run(m.mode, stereo, lines));
+			}
+		}
+		std::printf("\n");
+	}
+	std::printf("%-10s %16.2f %16.2f %16.2f %16.2f  (no baseline : new)\n", "Envelope",
+				bench.run(Sweep, false, false, true), bench.run(Sweep, false, true, true),
+				bench.run(Sweep, true, false, true), bench.run(Sweep, true, true, true));
+
+	return 0;
+}
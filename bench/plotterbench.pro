@@ -0,0 +1,52 @@
+# Copyright (C) 2020 Judd Niemann - All Rights Reserved.
+# You may use, distribute and modify this code under the
+# terms of the GNU Lesser General Public License, version 2.1
+#
+# You should have received a copy of GNU Lesser General Public License v2.1
+# with this file. If not, please refer to: https://github.com/jniemann66/sndscope
+
+# microbenchmark of the Plotter's point generation kernels (built separately from sndscope) :
+#   qmake bench/plotterbench.pro && make && ./plotterbench
+
+QT += core gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = plotterbench
+
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    plotterbench.cpp \
+    ../beamkernel.cpp \
+    ../beamrasteriser.cpp \
+    ../cpufeatures.cpp \
+    ../frameswapchain.cpp \
+    ../intensitydecay.cpp \
+    ../plotmode.cpp \
+    ../plotter.cpp \
+    ../sampleblock.cpp \
+    ../samplehistory.cpp \
+    ../segmentlengths.cpp \
+    ../triggerengine.cpp \
+    ../triggermode.cpp \
+    ../workerpool.cpp
+
+HEADERS += \
+    ../beamkernel.h \
+    ../beamrasteriser.h \
+    ../cpufeatures.h \
+    ../frameswapchain.h \
+    ../intensitydecay.h \
+    ../plotmode.h \
+    ../plotter.h \
+    ../sampleblock.h \
+    ../samplehistory.h \
+    ../segmentlengths.h \
+    ../triggerengine.h \
+    ../triggermode.h \
+    ../workerpool.h
@@ -0,0 +1,53 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "cpufeatures.h"
+
+#if defined(_MSC_VER) && defined(SNDSCOPE_SSE2)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+static CpuFeatures detectCpuFeatures()
+{
+	CpuFeatures features;
+
+#if defined(SNDSCOPE_SSE2)
+	features.sse2 = true;
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	features.fma = (info[2] & (1 << 12)) != 0;
+
+	// AVX state must also be enabled by the OS
+	const bool osAvx = osxsave && ((_xgetbv(0) & 0x6) == 0x6);
+	if (maxLeaf >= 7 && avx && osAvx) {
+		__cpuidex(info, 7, 0);
+		features.avx2 = (info[1] & (1 << 5)) != 0;
+	}
+	features.fma = features.fma && osAvx;
+#else
+	__builtin_cpu_init();
+	features.avx2 = __builtin_cpu_supports("avx2");
+	features.fma = __builtin_cpu_supports("fma");
+#endif
+#endif
+
+	return features;
+}
+
+const CpuFeatures &CpuFeatures::get()
+{
+	static const CpuFeatures features = detectCpuFeatures();
+	return features;
+}
@@ -0,0 +1,74 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#include <optional>
+
+// x86 SIMD support : SSE2 is assumed whenever the compiler targets it (always the case for x86-64),
+// while AVX2 / FMA code paths are compiled in regardless of compiler flags,
+// and selected at run-time (see CpuFeatures)
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SNDSCOPE_SSE2 1
+#endif
+
+#if defined(SNDSCOPE_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define SNDSCOPE_AVX2 1
+#endif
+
+// enable instruction set for a single function (gcc / clang); MSVC allows intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define SNDSCOPE_TARGET(t) __attribute__((target(t)))
+#else
+#define SNDSCOPE_TARGET(t)
+#endif
+
+// (an SSE2 / AVX2 implementation for select(), where compiled in)
+#ifdef SNDSCOPE_SSE2
+#define SNDSCOPE_SSE2_IMPLEMENTATION(...) std::optional{__VA_ARGS__}
+#else
+#define SNDSCOPE_SSE2_IMPLEMENTATION(...) std::nullopt
+#endif
+
+#ifdef SNDSCOPE_AVX2
+#define SNDSCOPE_AVX2_IMPLEMENTATION(...) std::optional{__VA_ARGS__}
+#else
+#define SNDSCOPE_AVX2_IMPLEMENTATION(...) std::nullopt
+#endif
+
+struct CpuFeatures
+{
+	bool sse2{false};
+	bool avx2{false};
+	bool fma{false};
+
+	// features of the CPU we are running on (detected once)
+	static const CpuFeatures &get();
+
+	// run-time dispatch : the best of a plain C++, an SSE2 and an AVX2 implementation (typically a struct of
+	// function pointers, and a name) for this CPU. Callers keep the result in a function-local static, eg
+	//   static const Impl implementation = CpuFeatures::select<Impl>({fScalar, "scalar"},
+	//       SNDSCOPE_SSE2_IMPLEMENTATION(Impl{fSSE2, "SSE2"}), SNDSCOPE_AVX2_IMPLEMENTATION(Impl{fAVX2, "AVX2"}));
+	template<typename Implementation>
+	static Implementation select(const Implementation &scalar,
+								 const std::optional<Implementation> &sse2,
+								 const std::optional<Implementation> &avx2,
+								 bool avx2NeedsFma = false)
+	{
+		const CpuFeatures &cpu = get();
+		if (avx2 && cpu.avx2 && (cpu.fma || !avx2NeedsFma)) {
+			return *avx2;
+		}
+		return sse2 ? *sse2 : scalar;
+	}
+};
+
+#endif // CPUFEATURES_H
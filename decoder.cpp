@@ -0,0 +1,195 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "decoder.h"
+
+#include "deinterleave.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+Decoder::Decoder(QObject *parent)
+	: QObject{parent}, fillTimer(this)
+{
+	fillTimer.setInterval(fillInterval_ms);
+	connect(&fillTimer, &QTimer::timeout, this, &Decoder::fill);
+}
+
+void Decoder::setSource(const SndfileHandle &newSndfile, SampleBlockPool *newPool, AudioRing *newAudioRing)
+{
+	close();
+
+	sndfile = newSndfile;
+	pool = newPool;
+	audioRing = newAudioRing;
+	numChannels = sndfile.channels();
+	blockFrames = inputBlockFrames(sndfile.samplerate());
+	channelPointers.resize(numChannels);
+	upsampler.setNumChannels(numChannels);
+
+	// pre-allocate all interleaved buffers, so that decoding never allocates
+	for (size_t i = 0; i < ring.capacity(); i++) {
+		ring.slot(i).interleaved.resize(blockFrames * numChannels);
+	}
+
+	// force a seek to start of file
+	generation = requestedGeneration.load(std::memory_order_acquire) - 1;
+	requestedFrame.store(0ll, std::memory_order_relaxed);
+
+	fillTimer.start();
+}
+
+void Decoder::close()
+{
+	fillTimer.stop();
+	releaseAll();
+	ring.reset();
+	numChannels = 0;
+}
+
+int64_t Decoder::inputBlockFrames(int sampleRate)
+{
+	return std::max(64, sampleRate / blocksPerSecond);
+}
+
+int64_t Decoder::sampleBlockFrames(int sampleRate)
+{
+	return inputBlockFrames(sampleRate) * UpsampleFactors::maxFactor(sampleRate);
+}
+
+void Decoder::releaseAll()
+{
+	// return any sample blocks still in the ring to the pool
+	for (size_t i = 0; i < ring.capacity(); i++) {
+		ring.slot(i).samples.reset();
+	}
+}
+
+int Decoder::requestSeek(int64_t frame)
+{
+	requestedFrame.store(frame, std::memory_order_relaxed);
+	const int g = requestedGeneration.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+	// don't wait for the next timer tick
+	QMetaObject::invokeMethod(this, &Decoder::fill, Qt::QueuedConnection);
+	return g;
+}
+
+void Decoder::setUpsampleFactor(int factor)
+{
+	requestedUpsampleFactor.store(factor, std::memory_order_relaxed);
+}
+
+int Decoder::getGeneration() const
+{
+	return requestedGeneration.load(std::memory_order_acquire);
+}
+
+DecodedBlock *Decoder::front()
+{
+	const int g = getGeneration();
+	DecodedBlock *block = ring.readSlot();
+
+	// discard anything decoded before the most recent seek
+	while (block != nullptr && block->generation != g) {
+		block->samples.reset();
+		ring.commitRead();
+		block = ring.readSlot();
+	}
+
+	return block;
+}
+
+void Decoder::pop()
+{
+	ring.readSlot()->samples.reset(); // (no-op if consumer took the samples)
+	ring.commitRead();
+}
+
+int64_t Decoder::getBlockFrames() const
+{
+	return blockFrames;
+}
+
+void Decoder::fill()
+{
+	if (numChannels == 0) {
+		return;
+	}
+
+	DecodedBlock *block = ring.writeSlot();
+	while (block != nullptr) {
+		const int g = requestedGeneration.load(std::memory_order_acquire);
+		if (g != generation) {
+			generation = g;
+			nextFrame = std::min<int64_t>(requestedFrame.load(std::memory_order_relaxed), sndfile.frames());
+			sndfile.seek(nextFrame, SEEK_SET);
+			upsampler.reset();
+			audioRing->discardQueued();
+		}
+
+		// a new upsampling factor takes effect from the next block, starting with fresh filter state
+		// (blocks already queued keep the old one, so nothing needs re-decoding, and audio isn't interrupted).
+		// SampleBlocks only have room for up to maxFactor
+		const int factor = UpsampleFactors::filter(std::min(requestedUpsampleFactor.load(std::memory_order_relaxed),
+															 UpsampleFactors::maxFactor(sndfile.samplerate()))).L;
+		if (factor != upsampler.getFactor()) {
+			upsampler.setFactor(factor);
+		}
+
+		if (audioRing->freeFrames() < blockFrames) { // audio output is far enough behind : try again later
+			break;
+		}
+
+		block->samples = pool->acquire();
+		if (block->samples == nullptr) { // pool exhausted : try again later
+			break;
+		}
+
+		const sf_count_t framesRead = sndfile.readf(block->interleaved.data(), blockFrames);
+		if (framesRead <= 0) { // end of file
+			block->samples.reset();
+			break;
+		}
+
+		decodeBlock(block, framesRead);
+		block->streamPosition = audioRing->writePosition();
+		audioRing->write(block->interleaved.constData(), framesRead);
+		ring.commitWrite();
+		block = ring.writeSlot();
+	}
+}
+
+void Decoder::decodeBlock(DecodedBlock *block, sf_count_t framesRead)
+{
+	block->generation = generation;
+	block->startFrame = nextFrame;
+	block->framesRead = framesRead;
+	nextFrame += framesRead;
+
+	const float *in = block->interleaved.constData();
+	SampleBlock *samples = block->samples.get();
+	samples->startFrame = block->startFrame;
+
+	for (int ch = 0; ch < numChannels; ch++) {
+		channelPointers[ch] = samples->channel(ch);
+	}
+
+	// de-interleave (and upsample, if enabled)
+	const int upsampleFactor = upsampler.getFactor();
+	samples->upsampleFactor = upsampleFactor;
+	if (upsampleFactor > 1) {
+		upsampler.upsampleBlock(channelPointers.data(), in, framesRead);
+		samples->frames = framesRead * upsampleFactor;
+	} else {
+		Deinterleave::toPlanar(channelPointers.data(), in, numChannels, framesRead);
+		samples->frames = framesRead;
+	}
+}
@@ -0,0 +1,105 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef DECODER_H
+#define DECODER_H
+
+#include "audioring.h"
+#include "sampleblock.h"
+#include "spscring.h"
+#include "upsampler.h"
+
+#include <sndfile.hh>
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include <atomic>
+#include <vector>
+
+// DecodedBlock : a chunk of consecutive audio frames read from the sound file.
+// interleaved holds the raw frames (which have also been queued for audio output, at streamPosition),
+// samples holds the same frames de-interleaved (and upsampled, if enabled) for the plotter.
+// The consumer may take ownership of samples (by moving it out), and pass it on to the plotter
+
+struct DecodedBlock
+{
+	int generation{0}; // seek generation at the time of decoding
+	int64_t startFrame{0ll}; // position (in file) of first frame
+	int64_t streamPosition{0ll}; // position (in AudioRing) of first frame
+	int64_t framesRead{0ll}; // number of audio frames in interleaved
+	QVector<float> interleaved;
+	SampleBlockPtr samples;
+};
+
+// Decoder : reads ahead from the sound file on its own thread,
+// filling a lock-free ring of DecodedBlocks which is drained by the GUI thread,
+// and an AudioRing which is drained by the audio output.
+// Seeking is asynchronous : requestSeek() bumps the generation, and blocks decoded
+// before the seek are silently discarded by front() (and their audio by the AudioRing)
+
+class Decoder : public QObject
+{
+	Q_OBJECT
+
+public:
+	static constexpr size_t ringCapacity = 256; // number of blocks (read-ahead is also limited by the AudioRing)
+	static constexpr int blocksPerSecond = 200;
+	static constexpr int fillInterval_ms = 5;
+
+	explicit Decoder(QObject *parent = nullptr);
+
+	// setSource() and close() must run on the decoder thread while the consumer is idle
+	// (ie call them via a blocking queued connection)
+	void setSource(const SndfileHandle &newSndfile, SampleBlockPool *newPool, AudioRing *newAudioRing);
+	void close();
+
+	// number of frames read from the file for each block
+	static int64_t inputBlockFrames(int sampleRate);
+
+	// size of SampleBlocks (frames per channel) needed for a given file (allowing for upsampling)
+	static int64_t sampleBlockFrames(int sampleRate);
+
+	// thread-safe functions, callable from the consumer thread
+	int requestSeek(int64_t frame);
+	void setUpsampleFactor(int factor); // (1 : no upsampling)
+	int getGeneration() const;
+
+	// consumer functions
+	DecodedBlock *front();
+	void pop();
+
+	// getters
+	int64_t getBlockFrames() const;
+
+private:
+	SpscRing<DecodedBlock, ringCapacity> ring;
+	QTimer fillTimer;
+	SndfileHandle sndfile;
+	SampleBlockPool *pool{nullptr};
+	AudioRing *audioRing{nullptr};
+	UpSampler<float, float> upsampler;
+	std::vector<float *> channelPointers; // (per-block scratch)
+
+	int numChannels{0};
+	int64_t blockFrames{0ll};
+	int64_t nextFrame{0ll}; // position of next read
+	int generation{0}; // generation currently being decoded
+
+	std::atomic<int> requestedGeneration{0};
+	std::atomic<int64_t> requestedFrame{0ll};
+	std::atomic<int> requestedUpsampleFactor{1};
+
+	void fill();
+	void decodeBlock(DecodedBlock *block, sf_count_t framesRead);
+	void releaseAll();
+};
+
+#endif // DECODER_H
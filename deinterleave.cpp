@@ -0,0 +1,81 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "deinterleave.h"
+
+#include "cpufeatures.h"
+
+#ifdef SNDSCOPE_SSE2
+#include <immintrin.h>
+#endif
+
+void Deinterleave::toPlanar(float *const *outputs, const float *interleaved, int numChannels, size_t frames)
+{
+	const size_t stride = static_cast<size_t>(numChannels);
+	int ch = 0;
+
+#ifdef SNDSCOPE_SSE2
+	const size_t simdFrames = frames & ~size_t{3};
+
+	// 4 channels x 4 frames at a time
+	for (; ch + 4 <= numChannels; ch += 4) {
+		const float *in = interleaved + ch;
+		float *out0 = outputs[ch];
+		float *out1 = outputs[ch + 1];
+		float *out2 = outputs[ch + 2];
+		float *out3 = outputs[ch + 3];
+		for (size_t f = 0; f < simdFrames; f += 4) {
+			__m128 r0 = _mm_loadu_ps(in + f * stride);
+			__m128 r1 = _mm_loadu_ps(in + (f + 1) * stride);
+			__m128 r2 = _mm_loadu_ps(in + (f + 2) * stride);
+			__m128 r3 = _mm_loadu_ps(in + (f + 3) * stride);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(out0 + f, r0);
+			_mm_storeu_ps(out1 + f, r1);
+			_mm_storeu_ps(out2 + f, r2);
+			_mm_storeu_ps(out3 + f, r3);
+		}
+		for (size_t f = simdFrames; f < frames; f++) {
+			out0[f] = in[f * stride];
+			out1[f] = in[f * stride + 1];
+			out2[f] = in[f * stride + 2];
+			out3[f] = in[f * stride + 3];
+		}
+	}
+
+	// then a pair of channels (eg stereo, or the last 2 channels of 5.1) x 4 frames at a time
+	if (ch + 2 <= numChannels) {
+		const float *in = interleaved + ch;
+		float *out0 = outputs[ch];
+		float *out1 = outputs[ch + 1];
+		for (size_t f = 0; f < simdFrames; f += 4) {
+			const __m128 r01 = _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(in + f * stride))),
+											reinterpret_cast<const __m64 *>(in + (f + 1) * stride));
+			const __m128 r23 = _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(in + (f + 2) * stride))),
+											reinterpret_cast<const __m64 *>(in + (f + 3) * stride));
+			_mm_storeu_ps(out0 + f, _mm_shuffle_ps(r01, r23, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(out1 + f, _mm_shuffle_ps(r01, r23, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+		for (size_t f = simdFrames; f < frames; f++) {
+			out0[f] = in[f * stride];
+			out1[f] = in[f * stride + 1];
+		}
+		ch += 2;
+	}
+#endif
+
+	// remaining channel(s)
+	for (; ch < numChannels; ch++) {
+		const float *in = interleaved + ch;
+		float *out = outputs[ch];
+		for (size_t f = 0; f < frames; f++) {
+			out[f] = in[f * stride];
+		}
+	}
+}
@@ -0,0 +1,25 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef DEINTERLEAVE_H
+#define DEINTERLEAVE_H
+
+#include <cstddef>
+
+// Deinterleave : splits interleaved frames (any number of channels) into planar buffers.
+// Channels are taken 4 at a time (then 2, then 1), and 4 frames at a time,
+// with a 4 x 4 SIMD transpose, so that 4, 6 and 8 channel material needs no scalar shuffling at all
+
+struct Deinterleave
+{
+	// outputs : one pointer per channel, each with room for 'frames' samples
+	static void toPlanar(float *const *outputs, const float *interleaved, int numChannels, size_t frames);
+};
+
+#endif // DEINTERLEAVE_H
@@ -93,14 +93,8 @@ DisplaySettingsWidget::DisplaySettingsWidget(QWidget *parent)
 
 		if (phosphors.contains(name)) {
 			Phosphor phosphor = phosphors.value(name);
-			QVector<QColor> phosphorColors;
-			for (int i = 0; i < phosphor.layers.count(); i++) {
-				const auto& c = phosphor.layers.at(i).color;
-				phosphorColors.append(c);
-			}
-
-			if (phosphorColors.count() > 0) {
-				emit phosphorColorChanged(phosphorColors);
+			if (phosphor.layers.count() > 0) {
+				emit phosphorChanged(phosphor);
 				setPersistence(phosphor.layers.at(0).persistence);
 			}
 		}
@@ -39,7 +39,7 @@ public:
 signals:
 	void brightnessChanged(double brightness);
 	void focusChanged(double focus);
-	void phosphorColorChanged(QVector<QColor>);
+	void phosphorChanged(const Phosphor &phosphor);
 	void persistenceChanged(int persistence);
 	void wipeScreenRequested();
 
@@ -0,0 +1,109 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef FILTERDESIGN_H
+#define FILTERDESIGN_H
+
+#include <array>
+#include <cstddef>
+
+// FilterDesign : compile-time FIR filter design.
+// (<cmath> functions aren't constexpr, so the few that are needed are implemented here as series expansions)
+
+struct FilterDesign
+{
+	static constexpr double pi = 3.14159265358979323846;
+
+	// Kaiser-windowed sinc lowpass filter of (odd) length N.
+	// cutoff : -6dB point, as a fraction of the sample rate (0.0 .. 0.5)
+	// beta : Kaiser window shape parameter (stopband attenuation ~ 8.7 + beta / 0.1102 dB)
+	template<size_t N>
+	static constexpr std::array<double, N> kaiserLowpass(double cutoff, double beta)
+	{
+		static_assert(N % 2 == 1, "filter length must be odd");
+
+		std::array<double, N> h{};
+		constexpr double center = (N - 1) / 2.0;
+		const double i0Beta = besselI0(beta);
+		for (size_t n = 0; n < N; n++) {
+			const double t = (static_cast<double>(n) - center);
+			const double r = (N > 1) ? t / center : 0.0;
+			const double window = besselI0(beta * sqrt(1.0 - r * r)) / i0Beta;
+			h[n] = 2.0 * cutoff * sinc(2.0 * cutoff * t) * window;
+		}
+		return h;
+	}
+
+	// sin(pi * x) / (pi * x)
+	static constexpr double sinc(double x)
+	{
+		return (x == 0.0) ? 1.0 : sinPi(x) / (pi * x);
+	}
+
+	// sin(pi * x)
+	static constexpr double sinPi(double x)
+	{
+		// reduce to [-1, 1], then to [-0.5, 0.5]
+		x -= 2.0 * static_cast<double>(static_cast<long long>(x / 2.0));
+		if (x > 1.0) {
+			x -= 2.0;
+		} else if (x < -1.0) {
+			x += 2.0;
+		}
+		if (x > 0.5) {
+			x = 1.0 - x;
+		} else if (x < -0.5) {
+			x = -1.0 - x;
+		}
+
+		// Taylor series
+		const double a = pi * x;
+		const double a2 = a * a;
+		double term = a;
+		double sum = a;
+		for (int k = 1; k < 20; k++) {
+			term *= -a2 / ((2 * k) * (2 * k + 1));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// zeroth-order modified Bessel function of the first kind
+	static constexpr double besselI0(double x)
+	{
+		const double q = x * x / 4.0;
+		double term = 1.0;
+		double sum = 1.0;
+		for (int k = 1; k < 100 && term > 1.0e-17 * sum; k++) {
+			term *= q / (static_cast<double>(k) * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	static constexpr double sqrt(double x)
+	{
+		if (x <= 0.0) {
+			return 0.0;
+		}
+
+		// Newton-Raphson
+		double y = (x > 1.0) ? x : 1.0;
+		for (int i = 0; i < 100; i++) {
+			const double next = 0.5 * (y + x / y);
+			if (next == y) {
+				break;
+			}
+			y = next;
+		}
+		return y;
+	}
+};
+
+#endif // FILTERDESIGN_H
@@ -0,0 +1,69 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "frameswapchain.h"
+
+void FrameSwapChain::resize(const QSize &newSize, const QColor &fillColor)
+{
+	for (QImage &image : images) {
+		image = QImage(newSize, QImage::Format_ARGB32_Premultiplied);
+		image.fill(fillColor);
+	}
+
+	renderIndex = 0;
+	presentIndex = 2;
+	readyIndex.store(1, std::memory_order_release);
+}
+
+QSize FrameSwapChain::size() const
+{
+	return images[0].size();
+}
+
+QImage *FrameSwapChain::renderTarget()
+{
+	return &images[renderIndex];
+}
+
+void FrameSwapChain::publish()
+{
+	const int published = renderIndex;
+	const int previous = readyIndex.exchange(published | freshBit, std::memory_order_acq_rel);
+	renderIndex = previous & indexMask;
+
+	renderedCount.fetch_add(1, std::memory_order_relaxed);
+	if (previous & freshBit) {
+		skippedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+bool FrameSwapChain::hasFreshFrame() const
+{
+	return (readyIndex.load(std::memory_order_acquire) & freshBit) != 0;
+}
+
+const QImage *FrameSwapChain::acquire()
+{
+	if (hasFreshFrame()) {
+		const int ready = readyIndex.exchange(presentIndex, std::memory_order_acq_rel);
+		presentIndex = ready & indexMask;
+		presentedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return &images[presentIndex];
+}
+
+FrameStats FrameSwapChain::getStats() const
+{
+	FrameStats stats;
+	stats.rendered = renderedCount.load(std::memory_order_relaxed);
+	stats.presented = presentedCount.load(std::memory_order_relaxed);
+	stats.skipped = skippedCount.load(std::memory_order_relaxed);
+	return stats;
+}
@@ -0,0 +1,65 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef FRAMESWAPCHAIN_H
+#define FRAMESWAPCHAIN_H
+
+#include <QColor>
+#include <QImage>
+#include <QSize>
+
+#include <array>
+#include <atomic>
+
+struct FrameStats
+{
+	int64_t rendered{0ll}; // frames published by the renderer
+	int64_t presented{0ll}; // frames picked up by the display
+	int64_t skipped{0ll}; // frames replaced by a newer frame before being presented
+};
+
+// FrameSwapChain : triple-buffered hand-off of rendered frames from the render thread to the GUI thread.
+// At any moment, one image is the render target (owned by renderer), one is ready (owned by nobody),
+// and one is being presented (owned by the GUI). Ownership changes hands through atomic exchanges of the
+// ready index, so neither side ever waits for the other, and the GUI never sees a partially-drawn frame.
+// The renderer redraws every frame in full (persistence is accumulated elsewhere, in the renderer's
+// intensity buffer), so render targets are handed back without their previous contents being restored.
+
+class FrameSwapChain
+{
+public:
+	// resize() may only be called while the renderer is idle, from the GUI thread
+	void resize(const QSize &newSize, const QColor &fillColor);
+	QSize size() const;
+
+	// renderer side
+	QImage *renderTarget();
+	void publish();
+
+	// presentation side
+	bool hasFreshFrame() const;
+	const QImage *acquire();
+
+	FrameStats getStats() const;
+
+private:
+	static constexpr int freshBit = 4;
+	static constexpr int indexMask = 3;
+
+	std::array<QImage, 3> images;
+	int renderIndex{0}; // owned by renderer
+	int presentIndex{2}; // owned by GUI
+	std::atomic<int> readyIndex{1}; // index | freshBit (if not yet presented)
+
+	std::atomic<int64_t> renderedCount{0ll};
+	std::atomic<int64_t> presentedCount{0ll};
+	std::atomic<int64_t> skippedCount{0ll};
+};
+
+#endif // FRAMESWAPCHAIN_H
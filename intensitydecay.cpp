@@ -0,0 +1,94 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "intensitydecay.h"
+
+#include "cpufeatures.h"
+
+#ifdef SNDSCOPE_SSE2
+#include <immintrin.h>
+#endif
+
+using DecayFunction = void (*)(float *values, size_t count, float factor, float threshold);
+
+static void decayScalar(float *values, size_t count, float factor, float threshold)
+{
+	for (size_t i = 0; i < count; i++) {
+		const float d = values[i] * factor;
+		values[i] = (d < threshold) ? 0.0f : d;
+	}
+}
+
+#ifdef SNDSCOPE_SSE2
+
+static void decaySSE2(float *values, size_t count, float factor, float threshold)
+{
+	const __m128 f = _mm_set1_ps(factor);
+	const __m128 t = _mm_set1_ps(threshold);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 d = _mm_mul_ps(_mm_loadu_ps(values + i), f);
+		_mm_storeu_ps(values + i, _mm_and_ps(d, _mm_cmpge_ps(d, t)));
+	}
+	decayScalar(values + i, count - i, factor, threshold);
+}
+
+#endif // SNDSCOPE_SSE2
+
+#ifdef SNDSCOPE_AVX2
+
+SNDSCOPE_TARGET("avx2")
+static void decayAVX2(float *values, size_t count, float factor, float threshold)
+{
+	const __m256 f = _mm256_set1_ps(factor);
+	const __m256 t = _mm256_set1_ps(threshold);
+	size_t i = 0;
+
+	// 2 vectors at a time
+	for (; i + 16 <= count; i += 16) {
+		const __m256 d0 = _mm256_mul_ps(_mm256_loadu_ps(values + i), f);
+		const __m256 d1 = _mm256_mul_ps(_mm256_loadu_ps(values + i + 8), f);
+		_mm256_storeu_ps(values + i, _mm256_and_ps(d0, _mm256_cmp_ps(d0, t, _CMP_GE_OQ)));
+		_mm256_storeu_ps(values + i + 8, _mm256_and_ps(d1, _mm256_cmp_ps(d1, t, _CMP_GE_OQ)));
+	}
+
+	for (; i + 8 <= count; i += 8) {
+		const __m256 d = _mm256_mul_ps(_mm256_loadu_ps(values + i), f);
+		_mm256_storeu_ps(values + i, _mm256_and_ps(d, _mm256_cmp_ps(d, t, _CMP_GE_OQ)));
+	}
+	decayScalar(values + i, count - i, factor, threshold);
+}
+
+#endif // SNDSCOPE_AVX2
+
+struct DecayImplementation
+{
+	DecayFunction function;
+	const char *name;
+};
+
+static const DecayImplementation &getImplementation()
+{
+	// (see CpuFeatures::select())
+	static const DecayImplementation implementation = CpuFeatures::select<DecayImplementation>(
+		{decayScalar, "scalar"},
+		SNDSCOPE_SSE2_IMPLEMENTATION(DecayImplementation{decaySSE2, "SSE2"}),
+		SNDSCOPE_AVX2_IMPLEMENTATION(DecayImplementation{decayAVX2, "AVX2"}));
+	return implementation;
+}
+
+void IntensityDecay::apply(float *values, size_t count, float factor, float threshold)
+{
+	getImplementation().function(values, count, factor, threshold);
+}
+
+const char *IntensityDecay::implementation()
+{
+	return getImplementation().name;
+}
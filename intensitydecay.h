@@ -0,0 +1,26 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef INTENSITYDECAY_H
+#define INTENSITYDECAY_H
+
+#include <cstddef>
+
+// IntensityDecay : exponential decay of phosphor intensities (multiply by a constant factor),
+// flushing anything that falls below a threshold to zero (so that traces fade out completely,
+// and the buffer doesn't fill up with denormals).
+// The best implementation for the CPU is selected at run-time
+
+struct IntensityDecay
+{
+	static void apply(float *values, size_t count, float factor, float threshold);
+	static const char *implementation();
+};
+
+#endif // INTENSITYDECAY_H
@@ -23,6 +23,7 @@
 #include <QFileDialog>
 #include <QMenuBar>
 #include <QMimeData>
+#include <QStatusBar>
 
 MainWindow::MainWindow(QWidget	*parent)
 	: QMainWindow(parent)
@@ -63,6 +64,7 @@ MainWindow::MainWindow(QWidget	*parent)
 	displaySettingsWidget->setBrightness(scopeWidget->getBrightness());
 	displaySettingsWidget->setFocus(scopeWidget->getFocus());
 	displaySettingsWidget->setPersistence(scopeWidget->getPersistence());
+	audioSettingsWidget->setBufferDuration_ms(scopeWidget->getAudioBufferDuration_ms());
 
 	setWindowTitle("Drag & drop a wave file");
 	setAcceptDrops(true);
@@ -85,6 +87,11 @@ MainWindow::MainWindow(QWidget	*parent)
 	preferencesMenu = menuBar()->addMenu("&Preferences");
 
 	connect(scopeWidget, &ScopeWidget::renderedFrame, transportWidget, &TransportWidget::setPosition);
+	connect(scopeWidget, &ScopeWidget::clockMetrics, this, [this](double avOffset_ms, double drift_ppm){
+		statusBar()->showMessage(QStringLiteral("A/V offset: %1 ms   clock drift: %2 ppm")
+								 .arg(avOffset_ms, 0, 'f', 1)
+								 .arg(drift_ppm, 0, 'f', 1));
+	});
 
 	connect(scopeWidget, &ScopeWidget::loadedFile, this, [sweepSettingsWidget, scopeWidget]{
 		sweepSettingsWidget->setSweepParameters(scopeWidget->getSweepParameters());
@@ -110,8 +117,8 @@ MainWindow::MainWindow(QWidget	*parent)
 		scopeWidget->setFocus(value);
 	});
 
-	connect(displaySettingsWidget, &DisplaySettingsWidget::phosphorColorChanged, this, [scopeWidget, displaySettingsWidget](const QVector<QColor>& colors){
-		scopeWidget->setPhosporColors(colors);
+	connect(displaySettingsWidget, &DisplaySettingsWidget::phosphorChanged, this, [scopeWidget, displaySettingsWidget](const Phosphor &phosphor){
+		scopeWidget->setPhosphor(phosphor);
 		scopeWidget->setFocus(displaySettingsWidget->getFocus());
 	});
 
@@ -130,6 +137,7 @@ MainWindow::MainWindow(QWidget	*parent)
 	});
 
 	connect(audioSettingsWidget, &AudioSettingsWidget::outputVolumeChanged, scopeWidget, &ScopeWidget::setAudioVolume);
+	connect(audioSettingsWidget, &AudioSettingsWidget::bufferDurationChanged, scopeWidget, &ScopeWidget::setAudioBufferDuration_ms);
 	connect(scopeWidget, &ScopeWidget::outputVolume, audioSettingsWidget, &AudioSettingsWidget::setVolume);
 
 	connect(sweepSettingsWidget, &SweepSettingsWidget::sweepParametersChanged, scopeWidget, &ScopeWidget::setSweepParameters);
@@ -138,6 +146,10 @@ MainWindow::MainWindow(QWidget	*parent)
 		scopeWidget->setShowTrigger(isPressed);
 	});
 
+	connect(sweepSettingsWidget, &SweepSettingsWidget::triggerPositionPressed, this, [scopeWidget](bool isPressed){
+		scopeWidget->setShowTriggerPosition(isPressed);
+	});
+
 	connect(plotmodeWidget, &PlotmodeWidget::plotmodeChanged, scopeWidget, &ScopeWidget::setPlotmode);
 	connect(plotmodeWidget, &PlotmodeWidget::plotmodeChanged, this, [sweepSettingsWidget](Plotmode plotmode){
 		sweepSettingsWidget->setEnabled(plotmode == Sweep);
@@ -145,6 +157,7 @@ MainWindow::MainWindow(QWidget	*parent)
 
 	connect(plotmodeWidget, &PlotmodeWidget::upsamplingChanged, scopeWidget, &ScopeWidget::setUpsampling);
 	connect(plotmodeWidget, &PlotmodeWidget::connectSamplesChanged, scopeWidget, &ScopeWidget::setconnectSamples);
+	connect(plotmodeWidget, &PlotmodeWidget::velocityModulationChanged, scopeWidget, &ScopeWidget::setVelocityModulation);
 
 	scopeWidget->setBrightness(80.0);
 	scopeWidget->setFocus(80.0);
@@ -157,6 +170,7 @@ MainWindow::MainWindow(QWidget	*parent)
 	sweepSettingsWidget->setEnabled(plotmode == Sweep);
 
 	plotmodeWidget->setconnectSamples(scopeWidget->getconnectSamples());
+	plotmodeWidget->setVelocityModulation(scopeWidget->getVelocityModulation());
 
 }
 
@@ -4,7 +4,7 @@ QMap<Plotmode, PlotmodeDefinition> PlotmodeManager::plotmodeMap
 {
 	{XY, {XY, "X / Y", "X Axis: Ch0<br/>Y Axis: Ch1"}},
 	{MidSide, {MidSide, "Mid / Side", "X Axis: Ch0 - Ch1<br/>Y Axis: Ch0 + Ch1"}},
-	{Sweep, {Sweep, "Sweep", "X Axis: Sweep<br/>Y Axis: ch0"}}
+	{Sweep, {Sweep, "Sweep", "X Axis: Sweep<br/>Y Axis: each channel, as its own trace"}}
 };
 
 const QMap<Plotmode, PlotmodeDefinition>& PlotmodeManager::getPlotmodeMap()
@@ -11,6 +11,9 @@ PlotmodeWidget::PlotmodeWidget(QWidget *parent)
 	upsamplingCheckbox = new QCheckBox("upsampling");
 	connectSamples = new QCheckBox("Connect Dots");
 	connectSamples->setChecked(true);
+	velocityModulation = new QCheckBox("Velocity Modulation");
+	velocityModulation->setToolTip("Fast-moving parts of the trace are dimmer than slow-moving ones (as on a real CRT)");
+	velocityModulation->setChecked(true);
 
 	auto plotmodeLayout = new QHBoxLayout;
 	auto mainLayout = new QVBoxLayout;
@@ -18,6 +21,7 @@ PlotmodeWidget::PlotmodeWidget(QWidget *parent)
 	plotmodeLayout->addWidget(plotmodeSelector);
 	plotmodeLayout->addWidget(upsamplingCheckbox);
 	plotmodeLayout->addWidget(connectSamples);
+	plotmodeLayout->addWidget(velocityModulation);
 
 	for (const PlotmodeDefinition& p : PlotmodeManager::getPlotmodeMap())
 	{
@@ -45,6 +49,10 @@ PlotmodeWidget::PlotmodeWidget(QWidget *parent)
 		emit connectSamplesChanged(connectSamples->isChecked());
 	});
 
+	connect(velocityModulation, &QCheckBox::toggled, this, [this]{
+		emit velocityModulationChanged(velocityModulation->isChecked());
+	});
+
 }
 
 Plotmode PlotmodeWidget::getPlotmode() const
@@ -68,3 +76,8 @@ void PlotmodeWidget::setconnectSamples(bool val)
 {
 	connectSamples->setChecked(val);
 }
+
+void PlotmodeWidget::setVelocityModulation(bool val)
+{
+	velocityModulation->setChecked(val);
+}
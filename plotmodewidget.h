@@ -23,16 +23,19 @@ public:
 
 	void setPlotmode(Plotmode newPlotmode);
 	void setconnectSamples(bool val);
+	void setVelocityModulation(bool val);
 
 signals:
 	void plotmodeChanged(Plotmode plotmode);
 	void upsamplingChanged(bool enableUpsampling);
 	void connectSamplesChanged(bool enableconnectSamples);
+	void velocityModulationChanged(bool enableVelocityModulation);
 
 private:
 	QComboBox *plotmodeSelector{nullptr};
 	QCheckBox *upsamplingCheckbox{nullptr};
 	QCheckBox *connectSamples{nullptr};
+	QCheckBox *velocityModulation{nullptr};
 };
 
 #endif // PLOTMODEWIDGET_H
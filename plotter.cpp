@@ -9,8 +9,6 @@
 
 #include "plotter.h"
 
-#include "delayline.h"
-#include "differentiator.h"
 
 //#define TIME_RENDER_FUNC
 #ifdef TIME_RENDER_FUNC
@@ -23,30 +21,76 @@
 #include <QDebug>
 #include <QEvent>
 #include <QPainter>
-#include <QPixmap>
 #include <QVector>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 Plotter::Plotter(QObject *parent)
 	: QObject{parent}
 {
+	updatePhosphor();
 }
 
 void Plotter::calcScaling()
 {
-	if (pixmap != nullptr) {
-		w = pixmap->width();
-		h = pixmap->height();
+	if (swapChain != nullptr) {
+		w = swapChain->size().width();
+		h = swapChain->size().height();
 		cx = 0.5 * w;
 		cy = 0.5 * h;
 
-		plotBuffer.reserve(4 * timeLimit_ms * audioFramesPerMs);
+		rasteriser.resize(static_cast<int>(w), static_cast<int>(h));
+		for (Trace &trace : traces) {
+			trace.plotBuffer.reserve(static_cast<qsizetype>(4 * timeLimit_ms * audioFramesPerMs));
+		}
 		sweepParameters.setWidthFrameRate(w, audioFramesPerMs);
+		calcTriggerPosition();
+		updateTraces();
+		resetSweep();
+	}
+}
+
+void Plotter::clearJobs()
+{
+	// return all sample blocks to their pool
+	jobQueue.reset();
+	for (size_t i = 0; i < jobQueue.capacity(); i++) {
+		jobQueue.slot(i).clear();
 	}
 }
 
-void Plotter::render(const QVector<QVector<float>> &inputBuffers, int64_t framesAvailable, int64_t currentFrame)
+bool Plotter::submit(RenderJob &job)
+{
+	RenderJob *slot = jobQueue.writeSlot();
+	if (slot == nullptr) {
+		return false; // renderer is behind : caller keeps (and can add to) job
+	}
+
+	// move sample blocks into the slot (caller gets back the slot's empty handles)
+	slot->blocks.swap(job.blocks);
+	slot->numBlocks = job.numBlocks;
+	slot->currentFrame = job.currentFrame;
+	job.numBlocks = 0;
+
+	jobQueue.commitWrite();
+	QMetaObject::invokeMethod(this, &Plotter::processJobs, Qt::QueuedConnection);
+	return true;
+}
+
+void Plotter::processJobs()
+{
+	RenderJob *job = jobQueue.readSlot();
+	while (job != nullptr) {
+		render(*job);
+		job->clear(); // recycle sample blocks
+		jobQueue.commitRead();
+		job = jobQueue.readSlot();
+	}
+}
+
+void Plotter::render(const RenderJob &job)
 {
 	bool panicMode = false;
 
@@ -87,142 +131,431 @@ void Plotter::render(const QVector<QVector<float>> &inputBuffers, int64_t frames
 #endif // TIME_RENDER_FUNC
 
 	constexpr bool catchAllFrames = false;
-	const bool drawLines =  ( (!connectSamplesSweepOnly || connectSamples) &&
-							  plotMode == Sweep  &&
-							  !panicMode &&
-							  (sweepParameters.getSamplesPerSweep() > 25)
+	// XY / MidSide are drawn as points, unless velocity modulation is on : then each sample is a segment from the
+	// one before (which still looks like a point where the beam dwells, but leaves fast retraces dim)
+	const bool xyLines = rasteriser.getVelocityModulation() || (connectSamples && !connectSamplesSweepOnly);
+	const bool drawLines =  ( !panicMode &&
+							  (plotMode == Sweep ? (connectSamples && sweepParameters.getSamplesPerSweep() > 25) : xyLines)
 							  );
 
-	// todo: whenever upsampling changes, reset this with upsampled value
-	int64_t expected = expectedFrames * sweepParameters.upsampleFactor;
-	int64_t firstFrameToPlot = catchAllFrames ? 0ll : std::max<int64_t>(0ll, framesAvailable - 2 * expected);
+	int64_t framesAvailable = 0ll;
+	for (int b = 0; b < job.numBlocks; b++) {
+		framesAvailable += job.blocks[b]->frames;
+	}
+
+	// (frames are counted at the upsampling factor of the newest block)
+	const int upsampleFactor = (job.numBlocks > 0) ? job.blocks[job.numBlocks - 1]->upsampleFactor : 1;
+	int64_t expected = expectedFrames * upsampleFactor;
+	int64_t framesToSkip = catchAllFrames ? 0ll : std::max<int64_t>(0ll, framesAvailable - 2 * expected);
 
 	// calculate all the points to draw
-	for (int64_t i = firstFrameToPlot; i < framesAvailable; i++) {
+	// (the kernel is chosen for this job's plot mode, channel count and line drawing, and chosen again if the
+	// upsampling factor changes : with many samples per pixel, each pixel column of the sweep collapses into a vertical span)
+	bool envelope = false;
+	PlotFunction plotFunction = nullptr;
+	for (int b = 0; b < job.numBlocks; b++) {
+		const SampleBlock *block = job.blocks[b].get();
+		if (framesToSkip >= block->frames) {
+			framesToSkip -= block->frames;
+			continue;
+		}
 
-		// types converted here : audio data is float, graphics is qreal (aka double)
-		double ch0val = static_cast<double>(inputBuffers[0][i]);
-		double ch1val = (numInputChannels > 1 ? static_cast<double>(inputBuffers[1][i]) : 0.0);
-		// ---
+		if (followUpsampleFactor(block) || plotFunction == nullptr) {
+			// (what the previous kernel plotted goes to the rasteriser first, as it was drawn)
+			addPlotBuffers(drawLines, envelope);
+			envelope = (plotMode == Sweep) && (sweepParameters.sweepAdvance * envelopeSamplesPerPixel < 1.0);
+			plotFunction = selectPlotFunction(plotMode, numInputChannels > 1, drawLines, envelope);
+		}
+		(this->*plotFunction)(block, framesToSkip);
+		framesToSkip = 0ll;
+	}
 
-		switch (plotMode) {
-		case XY:
-		default:
-		{
-			QPointF pt{(1.0 + ch0val) * cx, (1.0 - ch1val) * cy};
-			static QPointF lastPoint = pt;
-			if (drawLines) {
-				plotBuffer.append(lastPoint);
-			}
-			plotBuffer.append(pt);
-			lastPoint = pt;
+	constexpr bool debugPlotBufferSize = false;
+	if constexpr(debugPlotBufferSize) {
+		static qsizetype maxSize = 0ll;
+		if (traces[0].plotBuffer.size() > maxSize) {
+			maxSize = traces[0].plotBuffer.size();
+			qDebug() << "new size:" << maxSize;
 		}
-			break;
-		case MidSide:
-		{
-			static constexpr double rsqrt2 = 0.707;
-			QPointF pt{(1.0 + rsqrt2 * (ch0val - ch1val)) * cx,
-						(1.0 - rsqrt2 * (ch0val + ch1val)) * cy};
-			static QPointF lastPoint = pt;
-			if (drawLines) {
-				plotBuffer.append(lastPoint);
-			}
-			plotBuffer.append(pt);
-			lastPoint = pt;
+	}
+
+	addPlotBuffers(drawLines, envelope);
+
+	QImage *target = swapChain->renderTarget();
+	rasteriser.render(target);
+	drawOverlays(target, showTrigger, showTriggerPosition);
+
+	swapChain->publish();
+	emit renderedFrame(job.currentFrame);
+}
+
+// plot kernels : one instantiation per (plot mode, mono / stereo, points / lines), so that none of those
+// are tested per sample. Types are converted here : audio data is float, graphics is qreal (aka double)
+
+template<Plotmode mode, bool stereo, bool lines>
+void Plotter::plotXY(const SampleBlock *block, int64_t first)
+{
+	const float *in0 = block->channel(0) + first;
+	const float *in1 = block->channel(stereo ? 1 : 0) + first;
+	const int64_t frames = block->frames - first;
+	if (frames <= 0) {
+		return;
+	}
+
+	// XY : ch0 -> x, ch1 -> y. MidSide : rotated 45 degrees (mid is vertical, side is horizontal)
+	static constexpr double rsqrt2 = 0.707;
+	const qreal cx_ = cx;
+	const qreal cy_ = cy;
+	auto point = [in0, in1, cx_, cy_](int64_t i) {
+		const double ch0val = static_cast<double>(in0[i]);
+		const double ch1val = stereo ? static_cast<double>(in1[i]) : 0.0;
+		if constexpr (mode == MidSide) {
+			return QPointF{(1.0 + rsqrt2 * (ch0val - ch1val)) * cx_, (1.0 - rsqrt2 * (ch0val + ch1val)) * cy_};
+		} else {
+			return QPointF{(1.0 + ch0val) * cx_, (1.0 - ch1val) * cy_};
 		}
-			break;
-		case Sweep:
-		{
-			static Differentiator<double> d;
-			static DelayLine<double, d.delayTime> delayLine;
-			static bool triggered = false;
-			static qreal x = 0.0;
-			static QPointF lastPoint{0.0, cy * (1.0 - sweepParameters.triggerLevel)};
-			const double &source = ch0val;
-			double slope = d.get(source) * sweepParameters.slope;
-			double delayed = delayLine.get(source);
-
-			triggered = triggered
-						|| !sweepParameters.triggerEnabled // when trigger disabled -> Always Triggered
-						|| (sweepParameters.triggerMin <= delayed && delayed <= sweepParameters.triggerMax && slope > 0.0);
-
-			if (triggered) {
-				QPointF pt{x, cy * (1.0 - delayed)};
-				if (drawLines)  {
-					plotBuffer.append(lastPoint);
+	};
+
+	// (grow the buffer once, and write straight into it)
+	Trace &trace = traces[0];
+	const qsizetype start = trace.plotBuffer.size();
+	trace.plotBuffer.resize(start + (lines ? 2 * frames : frames));
+	QPointF *out = trace.plotBuffer.data() + start;
+
+	if constexpr (lines) {
+		// each point ends one line, and starts the next
+		out[0] = trace.lastPoint;
+		for (int64_t i = 0; i < frames - 1; i++) {
+			const QPointF pt = point(i);
+			out[2 * i + 1] = pt;
+			out[2 * i + 2] = pt;
+		}
+		out[2 * frames - 1] = point(frames - 1);
+	} else {
+		for (int64_t i = 0; i < frames; i++) {
+			out[i] = point(i);
+		}
+	}
+	trace.lastPoint = point(frames - 1);
+}
+
+template<bool lines, bool envelope>
+void Plotter::plotSweep(const SampleBlock *block, int64_t first)
+{
+	const int64_t frames = block->frames - first;
+	channelPointers.resize(static_cast<size_t>(numInputChannels));
+	for (int ch = 0; ch < numInputChannels; ch++) {
+		channelPointers[ch] = block->channel(ch) + first;
+	}
+
+	SweepState &s = sweepState;
+	TriggerEngine &trigger = s.trigger;
+	trigger.setInput(channelPointers.data(), numInputChannels, frames);
+
+	// keep the samples to be plotted (ie the delayed ones) for pre-trigger, before looking for triggers in them
+	// (the history only grows when the pre-trigger or the block size does, so it soon stops allocating)
+	const int64_t historyFrames = s.preTrigger + frames;
+	if (sweepHistory.getNumChannels() != numInputChannels || sweepHistory.getCapacityFrames() < historyFrames) {
+		sweepHistory.allocate(numInputChannels, historyFrames);
+	}
+	for (int ch = 0; ch < numInputChannels; ch++) {
+		channelPointers[ch] = trigger.delayedChannel(ch);
+	}
+	const int64_t blockPosition = sweepHistory.writePosition();
+	sweepHistory.write(channelPointers.data(), frames);
+
+	// plots one frame : a point (or line) for each trace, with sample(channel) giving each trace's sample.
+	// (envelope : collects the frame into each trace's current pixel column instead; see flushEnvelope())
+	const int n = numTraces;
+	auto plotFrame = [this, &s, n](auto sample) {
+		if constexpr (envelope) {
+			const int column = static_cast<int>(s.x);
+			if (s.penUp) {
+				for (int t = 0; t < n; t++) {
+					traces[t].envelope = {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.0f, 0.0, 0.0, 0, 0.0};
 				}
-				lastPoint = pt;
-				plotBuffer.append(pt);
-				x += sweepParameters.sweepAdvance;
-				if (x > w) { // sweep completed
-					x = 0.0;
-					triggered = false;
-					lastPoint = {x, cy * (1.0 - sweepParameters.triggerLevel)};
+				s.column = column;
+			} else if (column != s.column) {
+				flushEnvelope<lines>();
+				s.column = column;
+			}
+
+			for (int t = 0; t < n; t++) {
+				Trace &trace = traces[t];
+				Trace::Envelope &e = trace.envelope;
+				const float v = sample(trace.channel);
+				if constexpr (lines) {
+					// (the line from the previous sample, if there is one)
+					if (e.min <= e.max) {
+						const double dy = trace.yScale * static_cast<double>(v - e.last);
+						e.path += std::sqrt(sweepParameters.sweepAdvance * sweepParameters.sweepAdvance + dy * dy);
+					}
 				}
+				e.min = std::min(e.min, v);
+				e.max = std::max(e.max, v);
+				e.last = v;
+				e.sum += v;
+				e.sumSquares += static_cast<double>(v) * v;
+				e.count++;
+			}
+		} else {
+			for (int t = 0; t < n; t++) {
+				Trace &trace = traces[t];
+				const QPointF pt{s.x, trace.y0 - trace.yScale * static_cast<double>(sample(trace.channel))};
+				if (s.penUp) {
+					trace.lastPoint = pt;
+				}
+				if constexpr (lines) {
+					trace.plotBuffer.append(trace.lastPoint);
+				}
+				trace.lastPoint = pt;
+				trace.plotBuffer.append(pt);
+			}
+		}
+		s.penUp = false;
+		s.x += sweepParameters.sweepAdvance;
+	};
+
+	int64_t i = 0ll;
+	while (i < frames) {
+		if (!s.triggered) {
+			// wait out the holdoff, then skip straight to the next trigger (when trigger disabled -> Always Triggered)
+			const int64_t holdoff = std::min(s.holdoff, frames - i);
+			s.holdoff -= holdoff;
+			i += holdoff;
+			if (sweepParameters.triggerEnabled) {
+				i = trigger.findTrigger(i);
+			}
+			if (i == frames) {
+				break;
+			}
+			s.triggered = true;
+			s.delay = s.delayFrames;
+
+			// pre-trigger : replay the frames leading up to the trigger (as many of them as are still held)
+			const int64_t triggerPosition = blockPosition + i;
+			const int64_t start = std::max(triggerPosition - s.preTrigger, sweepHistory.oldestPosition());
+			s.x = (start - (triggerPosition - s.preTrigger)) * sweepParameters.sweepAdvance;
+			for (int64_t p = start; p < triggerPosition; p++) {
+				plotFrame([this, p](int ch) {
+					return sweepHistory.at(ch, p);
+				});
 			}
 		}
-			break;
 
-		} // ends switch
-	} // ends loop over i
+		if (s.delay > 0ll) {
+			// delayed sweep : the trigger is off-screen to the left
+			const int64_t delay = std::min(s.delay, frames - i);
+			s.delay -= delay;
+			i += delay;
+			if (i == frames) {
+				break;
+			}
+		}
 
-	constexpr bool debugPlotBufferSize = false;
-	if constexpr(debugPlotBufferSize) {
-		static decltype(plotBuffer.size()) maxSize = 0ll;
-		if (plotBuffer.size() > maxSize) {
-			maxSize = plotBuffer.size();
-			qDebug() << "new size:" << maxSize;
+		// plot until the sweep completes, or the block runs out
+		for (; i < frames; i++) {
+			plotFrame([&trigger, i](int ch) {
+				return trigger.delayed(ch, i);
+			});
+			if (s.x > w) { // sweep completed
+				if constexpr (envelope) {
+					flushEnvelope<lines>();
+				}
+				resetSweep();
+				i++;
+				break;
+			}
 		}
 	}
 
-#ifdef SNDSCOPE_BLEND2D
-	BLContext ctx;
-	ctx.begin(*blImageWrapper->getBlImage());
+	// (the trigger keeps watching the signal while sweeping, eg for the start of the next pulse)
+	trigger.finishBlock();
+}
+
+template<Plotmode mode, bool stereo, bool lines>
+constexpr Plotter::PlotFunction Plotter::plotFunction()
+{
+	if constexpr (mode == Sweep) {
+		return &Plotter::plotSweep<lines, false>; // (plots every visible channel)
+	} else {
+		return &Plotter::plotXY<mode, stereo, lines>;
+	}
+}
+
+Plotter::PlotFunction Plotter::selectPlotFunction(Plotmode mode, bool stereo, bool lines, bool envelope)
+{
+	// (envelope : Sweep only, and plots every visible channel)
+	if (envelope) {
+		return lines ? &Plotter::plotSweep<true, true> : &Plotter::plotSweep<false, true>;
+	}
+
+	// [plot mode][stereo][lines]
+	static constexpr PlotFunction table[3][2][2] {
+		{
+			{plotFunction<XY, false, false>(), plotFunction<XY, false, true>()},
+			{plotFunction<XY, true, false>(), plotFunction<XY, true, true>()}
+		},
+		{
+			{plotFunction<MidSide, false, false>(), plotFunction<MidSide, false, true>()},
+			{plotFunction<MidSide, true, false>(), plotFunction<MidSide, true, true>()}
+		},
+		{
+			{plotFunction<Sweep, false, false>(), plotFunction<Sweep, false, true>()},
+			{plotFunction<Sweep, true, false>(), plotFunction<Sweep, true, true>()}
+		}
+	};
+
+	const int m = (mode == MidSide || mode == Sweep) ? static_cast<int>(mode) : static_cast<int>(XY);
+	return table[m][stereo ? 1 : 0][lines ? 1 : 0];
+}
 
-	blImageWrapper->getBlImage();
-	//todo: draw some stuff
+void Plotter::addPlotBuffers(bool lines, bool envelope)
+{
+	// accumulate beam energy (converted to colour by the rasteriser's render())
+	for (int t = 0; t < numTraces; t++) {
+		const QVector<QPointF> &plotBuffer = traces[t].plotBuffer;
+		if (envelope) {
+			rasteriser.addLines(plotBuffer.constData(), plotBuffer.size(), beamEnergy, t, traces[t].weights.data());
+		} else if (lines) {
+			rasteriser.addLines(plotBuffer.constData(), plotBuffer.size(), beamEnergy, t);
+		} else {
+			rasteriser.addPoints(plotBuffer.constData(), plotBuffer.size(), beamEnergy, t);
+		}
+	}
+	clearPlotBuffers();
+}
 
-#else
+void Plotter::clearPlotBuffers()
+{
+	for (Trace &trace : traces) {
+		trace.plotBuffer.clear();
+		trace.weights.clear();
+	}
+}
 
+template<bool lines>
+void Plotter::flushEnvelope()
+{
+	// draw each trace's pixel column as a vertical span from min to max, standing in for all of the column's samples.
+	// Optionally, half of the energy goes into a core of +/- 1 standard deviation (the AC RMS) about the mean instead
+	const qreal x = sweepState.column + 0.5;
+	const bool velocityModulation = rasteriser.getVelocityModulation();
+	const double lineScale = rasteriser.getLineScale();
+	for (int t = 0; t < numTraces; t++) {
+		Trace &trace = traces[t];
+		Trace::Envelope &e = trace.envelope;
+		if (e.count == 0) {
+			continue;
+		}
 
-	QPainter painter(pixmap);
-	painter.beginNativePainting();
-	painter.setCompositionMode(compositionMode);
-	painter.setRenderHint(QPainter::TextAntialiasing, false);
+		auto span = [&trace, x](double lo, double hi, float weight) {
+			trace.plotBuffer.append(QPointF{x, trace.y0 - trace.yScale * hi});
+			trace.plotBuffer.append(QPointF{x, trace.y0 - trace.yScale * lo});
+			trace.weights.push_back(weight);
+		};
+
+		// the span gets the energy that the full plot would have put into the column : a point per sample
+		// (or with velocity modulation, a line per sample, each with the energy of a point). Otherwise, lines are as bright
+		// per pixel of length as a point, so the column gets that much for the length of the lines through it
+		const float weight = (!lines || velocityModulation) ? static_cast<float>(e.count) : static_cast<float>(e.path * lineScale);
+		if (sweepParameters.envelopeRms) {
+			const double mean = e.sum / e.count;
+			const double sd = std::sqrt(std::max(0.0, e.sumSquares / e.count - mean * mean));
+			span(e.min, e.max, 0.5f * weight);
+			span(mean - sd, mean + sd, 0.5f * weight);
+		} else {
+			span(e.min, e.max, weight);
+		}
 
-	if (--darkenCooldownCounter == 0) {
-		// darken:
-		painter.setBackgroundMode(Qt::OpaqueMode);
-		painter.setRenderHint(QPainter::Antialiasing, false);
-		painter.fillRect(pixmap->rect(), darkencolor);
-		darkenCooldownCounter = darkenNthFrame;
+		if constexpr (lines) {
+			// the next column carries on from the last sample (so that the spans join up)
+			e = {e.last, e.last, e.last, 0.0, 0.0, 0, 0.0};
+		} else {
+			e = {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.0f, 0.0, 0.0, 0, 0.0};
+		}
 	}
+}
 
-	// set pen
-	painter.setRenderHint(QPainter::Antialiasing, !panicMode);
-	const QPen pen{phosphorColor, beamWidth, Qt::SolidLine,
-				panicMode ? Qt::SquareCap : Qt::RoundCap,
-				Qt::BevelJoin};
-	painter.setPen(pen);
+void Plotter::resetSweep()
+{
+	// the next sweep starts at the left edge, with new lines
+	sweepState.x = 0.0;
+	sweepState.triggered = false;
+	sweepState.holdoff = sweepState.holdoffFrames;
+	sweepState.penUp = true;
+}
 
-	if (drawLines) {
-		painter.drawLines(plotBuffer);
+void Plotter::updateTraces()
+{
+	// Sweep : a trace for each visible channel. Otherwise : a single trace, in the phosphor's own colours
+	QVector<QColor> colors;
+	numTraces = 0;
+	if (plotMode == Sweep) {
+		for (int ch = 0; ch < numInputChannels && numTraces < BeamRasteriser::maxTraces; ch++) {
+			const TraceParameters p = sweepParameters.getTrace(ch);
+			if (p.visible) {
+				Trace &trace = traces[numTraces++];
+				trace.channel = ch;
+				trace.y0 = cy * (1.0 - p.offset);
+				trace.yScale = cy * p.scale;
+				colors.append(p.color);
+			}
+		}
 	} else {
-		painter.drawPoints(plotBuffer);
+		numTraces = 1;
+		traces[0].channel = 0;
+		colors.append(QColor{});
 	}
-	plotBuffer.clear();
-
+	rasteriser.setTraces(colors);
+}
 
+qreal Plotter::triggerY(double value) const
+{
+	// (trigger levels are drawn against the trace of the source channel; mid / side go with ch0)
+	const TraceParameters p = sweepParameters.getTrace(std::max(0, sweepParameters.triggerSource));
+	return cy * (1.0 - p.offset - p.scale * value);
+}
 
-	if (showTrigger) {
-		drawTrigger(&painter);
+void Plotter::calcTriggerPosition()
+{
+	// the trigger appears triggerPosition of the way across the screen (negative : off-screen to the left)
+	sweepState.preTrigger = 0ll;
+	sweepState.delayFrames = 0ll;
+	if (sweepParameters.sweepAdvance > 0.0) {
+		const double framesPerSweep = w / sweepParameters.sweepAdvance;
+		const int64_t offset = std::llround(sweepParameters.triggerPosition * framesPerSweep);
+		sweepState.preTrigger = std::clamp<int64_t>(offset, 0ll, static_cast<int64_t>(framesPerSweep));
+		sweepState.delayFrames = std::max<int64_t>(0ll, -offset);
 	}
+}
 
-	painter.endNativePainting();
-#endif
+void Plotter::updateTrigger()
+{
+	TriggerEngine::Settings settings;
+	settings.mode = sweepParameters.triggerMode;
+	settings.source = sweepParameters.triggerSource;
+	settings.level = sweepParameters.triggerLevel;
+	settings.tolerance = sweepParameters.triggerTolerance;
+	settings.slope = sweepParameters.slope;
+	settings.runtLevel = sweepParameters.runtLevel;
+	settings.minPulseWidth = sweepParameters.framesFor_ms(sweepParameters.pulseWidthMin_ms);
+	settings.maxPulseWidth = sweepParameters.framesFor_ms(sweepParameters.pulseWidthMax_ms);
+	sweepState.trigger.setSettings(settings);
+	sweepState.holdoffFrames = sweepParameters.framesFor_ms(sweepParameters.triggerHoldoff_ms);
+}
 
-	freshRender = true;
-	emit renderedFrame(currentFrame);
+void Plotter::triggerBand(double *yTop, double *yBottom) const
+{
+	// Window : level +/- tolerance. Otherwise : the hysteresis band, on the side the signal comes from
+	double a = sweepParameters.triggerMax;
+	double b = sweepParameters.triggerMin;
+	if (sweepParameters.triggerMode != WindowTrigger) {
+		a = sweepParameters.triggerLevel;
+		b = sweepParameters.triggerLevel - std::copysign(sweepParameters.triggerTolerance, sweepParameters.slope);
+	}
+	*yTop = std::min(triggerY(a), triggerY(b));
+	*yBottom = std::max(triggerY(a), triggerY(b));
 }
 
 void Plotter::drawTrigger(QPainter* painter)
@@ -233,12 +566,70 @@ void Plotter::drawTrigger(QPainter* painter)
 	const QBrush brush{QColor{64, 16, 16, 112}};
 	painter->setBrush(brush);
 	painter->setPen(pen);
-	double yMax = cy * (1.0 - sweepParameters.triggerMax);
-	double y = cy * (1.0 - sweepParameters.triggerLevel);
-	double yMin = cy * (1.0 - sweepParameters.triggerMin);
+	double yMax;
+	double yMin;
+	triggerBand(&yMax, &yMin);
+	double y = triggerY(sweepParameters.triggerLevel);
 	QRectF rect{QPointF{0, yMax}, QPointF{cx * 2, yMin}};
 	painter->drawRect(rect);
 	painter->drawLine(QPointF{0, y}, QPointF{cx * 2, y});
+	if (sweepParameters.triggerMode == RuntTrigger) {
+		const double yRunt = triggerY(sweepParameters.runtLevel);
+		painter->drawLine(QPointF{0, yRunt}, QPointF{cx * 2, yRunt});
+	}
+}
+
+void Plotter::drawTriggerPosition(QPainter *painter)
+{
+	// (a delayed sweep's trigger is off-screen to the left)
+	if (sweepParameters.triggerPosition > 0.0) {
+		painter->setRenderHint(QPainter::Antialiasing, false);
+		painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+		painter->setPen(QPen{QColor{128, 32, 32, 192}, 1.5, Qt::SolidLine, Qt::RoundCap, Qt::BevelJoin});
+		const double xTrigger = sweepParameters.triggerPosition * w;
+		painter->drawLine(QPointF{xTrigger, 0}, QPointF{xTrigger, h});
+	}
+}
+
+void Plotter::drawOverlays(QImage *target, bool trigger, bool triggerPosition)
+{
+	// (the trace itself is drawn by the rasteriser; this is just what goes on top of it).
+	// The trigger level is shown along with where the trigger is; the position can be shown on its own
+	if (!trigger && !triggerPosition) {
+		return;
+	}
+
+	QPainter painter(target);
+	if (trigger) {
+		drawTrigger(&painter);
+	}
+	drawTriggerPosition(&painter);
+	painter.end();
+
+	// (the overlays will need painting out again, even where the trace is empty)
+	rasteriser.invalidate(target);
+}
+
+void Plotter::wipe()
+{
+	rasteriser.clear();
+	rasteriser.render(swapChain->renderTarget(), 0);
+	swapChain->publish();
+}
+
+void Plotter::showTriggerPreview(bool trigger, bool triggerPosition)
+{
+	// (redraw the frozen trace, with or without the trigger on top)
+	QImage *target = swapChain->renderTarget();
+	rasteriser.render(target, 0);
+	drawOverlays(target, trigger, triggerPosition);
+
+	swapChain->publish();
+}
+
+void Plotter::updatePhosphor()
+{
+	rasteriser.setLayers(backgroundColor, phosphorLayers);
 }
 
 bool Plotter::getShowTrigger() const
@@ -251,6 +642,16 @@ void Plotter::setShowTrigger(bool newShowTrigger)
 	showTrigger = newShowTrigger;
 }
 
+bool Plotter::getShowTriggerPosition() const
+{
+	return showTriggerPosition;
+}
+
+void Plotter::setShowTriggerPosition(bool newShowTriggerPosition)
+{
+	showTriggerPosition = newShowTriggerPosition;
+}
+
 bool Plotter::getconnectSamples() const
 {
 	return connectSamples;
@@ -261,17 +662,15 @@ void Plotter::setconnectSamples(bool newconnectSamples)
 	connectSamples = newconnectSamples;
 }
 
-#ifdef SNDSCOPE_BLEND2D
-BLImageWrapper *Plotter::getBlImageWrapper() const
+bool Plotter::getVelocityModulation() const
 {
-	return blImageWrapper;
+	return rasteriser.getVelocityModulation();
 }
 
-void Plotter::setBlImageWrapper(BLImageWrapper *newBlImageWrapper)
+void Plotter::setVelocityModulation(bool newVelocityModulation)
 {
-	blImageWrapper = newBlImageWrapper;
+	rasteriser.setVelocityModulation(newVelocityModulation);
 }
-#endif
 
 SweepParameters Plotter::getSweepParameters() const
 {
@@ -281,70 +680,53 @@ SweepParameters Plotter::getSweepParameters() const
 void Plotter::setSweepParameters(const SweepParameters &newSweepParameters)
 {
 	sweepParameters = newSweepParameters;
+	updateTrigger();
 	calcScaling();
 }
 
-double Plotter::getTimeLimit_ms() const
+bool Plotter::followUpsampleFactor(const SampleBlock *block)
 {
-	return timeLimit_ms;
-}
+	// the decoder changes upsampling factor between blocks, without re-decoding : timing is per block
+	if (block->upsampleFactor == sweepParameters.upsampleFactor) {
+		return false;
+	}
 
-void Plotter::setTimeLimit_ms(double newTimeLimit_ms)
-{
-	timeLimit_ms = newTimeLimit_ms;
+	sweepParameters.setUpsampleFactor(static_cast<double>(block->upsampleFactor));
+	updateTrigger();
+	calcScaling();
+	return true;
 }
 
-bool Plotter::getFreshRender() const
+double Plotter::getTimeLimit_ms() const
 {
-	return freshRender;
+	return timeLimit_ms;
 }
 
-void Plotter::setFreshRender(bool newFreshRender)
+void Plotter::setTimeLimit_ms(double newTimeLimit_ms)
 {
-	freshRender = newFreshRender;
+	timeLimit_ms = newTimeLimit_ms;
 }
 
-QPixmap *Plotter::getPixmap() const
+FrameSwapChain *Plotter::getSwapChain() const
 {
-	return pixmap;
+	return swapChain;
 }
 
-void Plotter::setPixmap(QPixmap *newPixmap)
+void Plotter::setSwapChain(FrameSwapChain *newSwapChain)
 {
-	pixmap = newPixmap;
+	swapChain = newSwapChain;
 }
 
-int Plotter::getAudioFramesPerMs() const
+double Plotter::getAudioFramesPerMs() const
 {
 	return audioFramesPerMs;
 }
 
-void Plotter::setAudioFramesPerMs(int newAudioFramesPerMs)
+void Plotter::setAudioFramesPerMs(double newAudioFramesPerMs)
 {
 	audioFramesPerMs = newAudioFramesPerMs;
 }
 
-QColor Plotter::getDarkencolor() const
-{
-	return darkencolor;
-}
-
-void Plotter::setDarkencolor(const QColor &newDarkencolor)
-{
-	darkencolor = newDarkencolor;
-}
-
-int Plotter::getDarkenNthFrame() const
-{
-	return darkenNthFrame;
-}
-
-void Plotter::setDarkenNthFrame(int newDarkenNthFrame)
-{
-	darkenNthFrame = newDarkenNthFrame;
-	darkenCooldownCounter = darkenNthFrame;
-}
-
 int64_t Plotter::getExpectedFrames() const
 {
 	return expectedFrames;
@@ -355,24 +737,24 @@ void Plotter::setExpectedFrames(int64_t newExpectedFrames)
 	expectedFrames = newExpectedFrames;
 }
 
-qreal Plotter::getBeamWidth() const
+std::shared_ptr<const BeamKernel> Plotter::getBeamKernel() const
 {
-	return beamWidth;
+	return rasteriser.getKernel();
 }
 
-void Plotter::setBeamWidth(qreal newBeamWidth)
+void Plotter::setBeamKernel(const std::shared_ptr<const BeamKernel> &newBeamKernel)
 {
-	beamWidth = newBeamWidth;
+	rasteriser.setKernel(newBeamKernel);
 }
 
-qreal Plotter::getBeamIntensity() const
+qreal Plotter::getBeamEnergy() const
 {
-	return beamIntensity;
+	return beamEnergy;
 }
 
-void Plotter::setBeamIntensity(qreal newBeamIntensity)
+void Plotter::setBeamEnergy(qreal newBeamEnergy)
 {
-	beamIntensity = newBeamIntensity;
+	beamEnergy = newBeamEnergy;
 }
 
 int Plotter::getNumInputChannels() const
@@ -383,26 +765,29 @@ int Plotter::getNumInputChannels() const
 void Plotter::setNumInputChannels(int newNumInputChannels)
 {
 	numInputChannels = newNumInputChannels;
+	updateTraces();
 }
 
-QColor Plotter::getPhosphorColor() const
+QVector<BeamRasteriser::Layer> Plotter::getPhosphorLayers() const
 {
-	return phosphorColor;
+	return phosphorLayers;
 }
 
-void Plotter::setPhosphorColor(const QColor &newPhosphorColor)
+void Plotter::setPhosphorLayers(const QVector<BeamRasteriser::Layer> &newPhosphorLayers)
 {
-	phosphorColor = newPhosphorColor;
+	phosphorLayers = newPhosphorLayers;
+	updatePhosphor();
 }
 
-QPainter::CompositionMode Plotter::getCompositionMode() const
+QColor Plotter::getBackgroundColor() const
 {
-	return compositionMode;
+	return backgroundColor;
 }
 
-void Plotter::setCompositionMode(QPainter::CompositionMode newCompositionMode)
+void Plotter::setBackgroundColor(const QColor &newBackgroundColor)
 {
-	compositionMode = newCompositionMode;
+	backgroundColor = newBackgroundColor;
+	updatePhosphor();
 }
 
 Plotmode Plotter::getPlotMode() const
@@ -413,5 +798,10 @@ Plotmode Plotter::getPlotMode() const
 void Plotter::setPlotMode(Plotmode newPlotMode)
 {
 	plotMode = newPlotMode;
+	updateTraces();
+	resetSweep();
+	if (plotMode != Sweep) {
+		traces[0].lastPoint = {cx, cy}; // (beam at rest)
+	}
 }
 
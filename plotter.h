@@ -11,99 +11,205 @@
 #ifndef PLOTTER_H
 #define PLOTTER_H
 
+#include "beamrasteriser.h"
+#include "frameswapchain.h"
 #include "plotmode.h"
+#include "sampleblock.h"
+#include "samplehistory.h"
+#include "spscring.h"
 #include "sweepparameters.h"
+#include "triggerengine.h"
 
 #include <QImage>
 #include <QObject>
 #include <QPainter>
+#include <QVector>
 
-#ifdef SNDSCOPE_BLEND2D
-	#include <blimagewrapper.h>
-#endif
+#include <array>
+#include <vector>
+
+// RenderJob : a batch of sample blocks, submitted to the Plotter for rendering.
+// The job owns its blocks; they go back to their pool once the job has been rendered
+
+struct RenderJob
+{
+	static constexpr int maxBlocks = 16;
+
+	std::array<SampleBlockPtr, maxBlocks> blocks;
+	int numBlocks{0};
+	int64_t currentFrame{0ll}; // file position after last frame
+
+	void clear()
+	{
+		for (int b = 0; b < numBlocks; b++) {
+			blocks[b].reset();
+		}
+		numBlocks = 0;
+	}
+};
+
+// Plotter : lives on the render thread, and renders jobs submitted from the GUI thread.
+// Apart from submit(), all functions are to be called on the render thread
+// (ie via queued invocation), or while the render thread is idle.
 
 class Plotter : public QObject
 {
 	Q_OBJECT
 
 public:
+	static constexpr size_t jobQueueCapacity = 4;
+
 	explicit Plotter(QObject *parent = nullptr);
-	void render(const QVector<QVector<float> > &inputBuffers, int64_t framesAvailable, int64_t currentFrame);
+	void render(const RenderJob &job);
 	void calcScaling();
 
+	// job queue
+	void clearJobs();
+	bool submit(RenderJob &job);
+
 	// getters
 	SweepParameters getSweepParameters() const;
 	double getTimeLimit_ms() const;
-	bool getFreshRender() const;
-	QPixmap *getPixmap() const;
-	int getAudioFramesPerMs() const;
-	QColor getDarkencolor() const;
-	int getDarkenNthFrame() const;
+	FrameSwapChain *getSwapChain() const;
+	double getAudioFramesPerMs() const;
 	int64_t getExpectedFrames() const;
-	qreal getBeamWidth() const;
-	qreal getBeamIntensity() const;
+	std::shared_ptr<const BeamKernel> getBeamKernel() const;
+	qreal getBeamEnergy() const;
 	int getNumInputChannels() const;
-	QColor getPhosphorColor() const;
-	QPainter::CompositionMode getCompositionMode() const;
+	QVector<BeamRasteriser::Layer> getPhosphorLayers() const;
+	QColor getBackgroundColor() const;
 	Plotmode getPlotMode() const;
 	bool getconnectSamples() const;
+	bool getVelocityModulation() const;
 	bool getShowTrigger() const;
+	bool getShowTriggerPosition() const;
 
 	// setters
 	void setSweepParameters(const SweepParameters &newSweepParameters);
 	void setTimeLimit_ms(double newTimeLimit_ms);
-	void setFreshRender(bool newFreshRender);
-	void setPixmap(QPixmap *newPixmap);
-	void setAudioFramesPerMs(int newAudioFramesPerMs);
-	void setDarkencolor(const QColor &newDarkencolor);
-	void setDarkenNthFrame(int newDarkenNthFrame);
+	void setSwapChain(FrameSwapChain *newSwapChain);
+	void setAudioFramesPerMs(double newAudioFramesPerMs);
 	void setExpectedFrames(int64_t newExpectedFrames);
-	void setBeamWidth(qreal newBeamWidth);
-	void setBeamIntensity(qreal newBeamIntensity);
+	void setBeamKernel(const std::shared_ptr<const BeamKernel> &newBeamKernel);
+	void setBeamEnergy(qreal newBeamEnergy);
 	void setNumInputChannels(int newNumInputChannels);
-	void setPhosphorColor(const QColor &newPhosphorColor);
-	void setCompositionMode(QPainter::CompositionMode newCompositionMode);
+	void setPhosphorLayers(const QVector<BeamRasteriser::Layer> &newPhosphorLayers);
+	void setBackgroundColor(const QColor &newBackgroundColor);
 	void setPlotMode(Plotmode newPlotMode);
 	void setconnectSamples(bool newconnectSamples);
+	void setVelocityModulation(bool newVelocityModulation);
 	void setShowTrigger(bool newShowTrigger);
+	void setShowTriggerPosition(bool newShowTriggerPosition);
 
 	void drawTrigger(QPainter *painter);
+	void drawTriggerPosition(QPainter *painter);
+	void wipe();
+	void showTriggerPreview(bool trigger, bool triggerPosition);
 
 signals:
 	void renderedFrame(int64_t frame);
 
+protected:
+	// point generation : plots a block of samples (from frame 'first' onwards) into the traces' plot buffers.
+	// (bench/plotterbench.cpp times the kernels through a subclass)
+	using PlotFunction = void (Plotter::*)(const SampleBlock *block, int64_t first);
+
+	static PlotFunction selectPlotFunction(Plotmode mode, bool stereo, bool lines, bool envelope);
+	void clearPlotBuffers();
+
 private:
-	QVector<QPointF> plotBuffer;
+	SpscRing<RenderJob, jobQueueCapacity> jobQueue;
+	BeamRasteriser rasteriser;
 	SweepParameters sweepParameters;
-	QPixmap* pixmap{nullptr};
+	FrameSwapChain *swapChain{nullptr};
 	double timeLimit_ms;
 	int64_t expectedFrames{0ll}; // number of audioframes expected per plotTimer timeout
-	bool freshRender{false};
-	int audioFramesPerMs{0};
-	Plotmode plotMode;
+	double audioFramesPerMs{0.0};
+	Plotmode plotMode{XY};
 	bool connectSamples{false};
 	qreal cx;
 	qreal cy;
 	qreal w;
 	qreal h;
-	int darkenCooldownCounter{1};
-	QPainter::CompositionMode compositionMode{QPainter::CompositionMode_SourceOver};
-	qreal beamWidth;
-	qreal beamIntensity;
-	QColor phosphorColor{0x3e, 0xff, 0x6f, 0xff};
-	QColor darkencolor{0, 0, 0, 0};
-	int darkenNthFrame{1};
-	int numInputChannels;
+	qreal beamEnergy{0.0}; // energy deposited by one sample (unclamped)
+	QVector<BeamRasteriser::Layer> phosphorLayers{{QColor{0x3e, 0xff, 0x6f, 0xff}, 0.9}};
+	QColor backgroundColor{0, 0, 0, 255};
+	int numInputChannels{1};
 	bool showTrigger{false};
+	bool showTriggerPosition{false};
 
-	//bl.createFromData(img->width(), img->height(), BL_FORMAT_PRGB32, img->bits(), img->bytesPerLine());
-#ifdef SNDSCOPE_BLEND2D
-	BLImageWrapper *blImageWrapper;
-public:
-	BLImageWrapper *getBlImageWrapper() const;
-	void setBlImageWrapper(BLImageWrapper *newBlImageWrapper);
-#endif
+	// Sweep : a trace for each visible channel. Otherwise : just the first trace
+	struct Trace
+	{
+		int channel{0};
+		qreal y0{0.0}; // (y = y0 - yScale * sample)
+		qreal yScale{0.0};
+		QVector<QPointF> plotBuffer;
+		QPointF lastPoint; // (where the next line starts from)
+
+		// envelope : the pixel column being collected (lines : extended to the last sample of the column before)
+		struct Envelope
+		{
+			float min;
+			float max;
+			float last;
+			double sum;
+			double sumSquares;
+			int count;
+			double path; // (lines : length, in pixels, of the lines joining the column's samples)
+		};
+
+		Envelope envelope{};
+		std::vector<float> weights; // (envelope : per line in plotBuffer, the energy it stands for, in points)
+	};
+
+	std::array<Trace, BeamRasteriser::maxTraces> traces;
+	int numTraces{1};
+
+	struct SweepState
+	{
+		TriggerEngine trigger;
+		bool triggered{false};
+		qreal x{0.0};
+		int64_t holdoffFrames{0ll};
+		int64_t holdoff{0ll}; // (frames of holdoff remaining)
+		int64_t preTrigger{0ll}; // (frames shown before the trigger)
+		int64_t delayFrames{0ll}; // (frames skipped after the trigger, when it is off-screen to the left)
+		int64_t delay{0ll}; // (frames of delay remaining)
+		bool penUp{true}; // (the next frame starts new lines, rather than continuing the last ones)
+		int column{0}; // (envelope : pixel column being collected)
+	};
+
+	// with more samples than this per pixel, sweeps are drawn as a min / max envelope : a vertical span per pixel column
+	static constexpr double envelopeSamplesPerPixel = 4.0;
+
+	SweepState sweepState;
+	SampleHistory sweepHistory; // (what has been fed to the sweep, for pre-trigger)
+	std::vector<const float *> channelPointers; // (scratch, for plotSweep())
+
+	template<Plotmode mode, bool stereo, bool lines>
+	void plotXY(const SampleBlock *block, int64_t first);
+
+	template<bool lines, bool envelope>
+	void plotSweep(const SampleBlock *block, int64_t first);
+	template<bool lines>
+	void flushEnvelope();
+
+	template<Plotmode mode, bool stereo, bool lines>
+	static constexpr PlotFunction plotFunction();
+
+	void resetSweep();
+	void updateTrigger();
+	bool followUpsampleFactor(const SampleBlock *block); // (returns true if the factor changed)
+	void calcTriggerPosition();
+	void updateTraces();
+	qreal triggerY(double value) const;
+	void triggerBand(double *yTop, double *yBottom) const;
 
+	void addPlotBuffers(bool lines, bool envelope);
+	void processJobs();
+	void updatePhosphor();
+	void drawOverlays(QImage *target, bool trigger, bool triggerPosition);
 };
 
 #endif // PLOTTER_H
@@ -0,0 +1,318 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "polyphase.h"
+
+#include "cpufeatures.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef SNDSCOPE_SSE2
+#include <immintrin.h>
+#endif
+
+using UpsampleFunction = void (*)(float *, const float *, size_t, size_t, float *, size_t &, const Polyphase::Filter &);
+
+// append up to 'count' samples to the history, and return the number appended (the chunk).
+// The window for chunk sample j (newest sample first) then starts at history + pos + (chunk - 1 - j),
+// and the same sample (in chronological order) is at chronologicalNewest(history, pos, taps, chunk) + j.
+// Samples are written for a whole chunk before any are read back, so that loads never wait on recent stores.
+// (The chronological buffer is only maintained for the folded form)
+template<bool chronologicalOrder>
+static inline size_t pushHistory(float *history, size_t &pos, size_t taps, const float *input, size_t inputStride, size_t count)
+{
+	float *chronological = history + 2 * taps;
+
+	// reached the bottom of the buffer : slide the most recent taps - 1 samples back up to the top
+	// (and likewise for the chronological buffer, which fills in the opposite direction)
+	if (pos == 0) {
+		std::memmove(history + taps + 1, history, (taps - 1) * sizeof(float));
+		if constexpr (chronologicalOrder) {
+			std::memmove(chronological, chronological + taps + 1, (taps - 1) * sizeof(float));
+		}
+		pos = taps + 1;
+	}
+
+	const size_t chunk = std::min(count, pos);
+	const size_t q = 2 * taps - pos;
+	for (size_t j = 0; j < chunk; j++) {
+		const float x = input[j * inputStride];
+		history[pos - 1 - j] = x;
+		if constexpr (chronologicalOrder) {
+			chronological[q + j] = x;
+		}
+	}
+	pos -= chunk;
+	return chunk;
+}
+
+static inline const float *chronologicalNewest(const float *history, size_t pos, size_t taps, size_t chunk)
+{
+	return history + 2 * taps + (2 * taps - pos - chunk);
+}
+
+// Each implementation consists of a function which computes all L outputs for a single window,
+// and a driver which feeds it whole chunks of input at a time.
+// For the folded form, the function also receives a pointer to the newest sample in the chronological buffer;
+// the row(s) for a phase of length n then pair window[i] with (newest - (n - 1))[i]
+
+static inline void phasesScalar(float *output, const float *window, const float *coeffs, size_t taps, int L)
+{
+	for (int k = 0; k < L; k++) {
+		// (independent partial sums, so that the compiler is free to vectorize)
+		const float *c = coeffs + k * taps;
+		float acc[4] {0.0f, 0.0f, 0.0f, 0.0f};
+		for (size_t i = 0; i < taps; i += 4) {
+			acc[0] += window[i] * c[i];
+			acc[1] += window[i + 1] * c[i + 1];
+			acc[2] += window[i + 2] * c[i + 2];
+			acc[3] += window[i + 3] * c[i + 3];
+		}
+		output[k] = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+	}
+}
+
+static inline void foldedPhasesScalar(float *output, const float *window, const float *newest, const Polyphase::Filter &filter)
+{
+	const size_t foldedTaps = filter.foldedTaps;
+	for (int r = 0; r < filter.numRows; r++) {
+		const Polyphase::FoldedRow &row = filter.rows[r];
+		const float *reversed = newest - (row.length - 1);
+		const float *c = filter.foldedCoeffs + r * foldedTaps;
+		if (row.type == Polyphase::Symmetric) {
+			float acc[4] {0.0f, 0.0f, 0.0f, 0.0f};
+			for (size_t i = 0; i < foldedTaps; i += 4) {
+				for (size_t m = 0; m < 4; m++) {
+					acc[m] += c[i + m] * (window[i + m] + reversed[i + m]);
+				}
+			}
+			output[row.output] = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+		} else {
+			// sum and difference rows : computed together, as they share the same inputs
+			const float *d = c + foldedTaps;
+			float sum[4] {0.0f, 0.0f, 0.0f, 0.0f};
+			float difference[4] {0.0f, 0.0f, 0.0f, 0.0f};
+			for (size_t i = 0; i < foldedTaps; i += 4) {
+				for (size_t m = 0; m < 4; m++) {
+					sum[m] += c[i + m] * (window[i + m] + reversed[i + m]);
+					difference[m] += d[i + m] * (window[i + m] - reversed[i + m]);
+				}
+			}
+			const float s = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+			const float t = (difference[0] + difference[1]) + (difference[2] + difference[3]);
+			output[row.output] = s + t;
+			output[row.partner] = s - t;
+			r++;
+		}
+	}
+}
+
+static void upsampleScalar(float *output, const float *input, size_t inputStride, size_t count,
+						   float *history, size_t &pos, const Polyphase::Filter &filter)
+{
+	const float *coeffs = filter.coeffs;
+	const size_t taps = filter.taps;
+	const int L = filter.L;
+	while (count > 0) {
+		const size_t chunk = pushHistory<false>(history, pos, taps, input, inputStride, count);
+		for (size_t j = 0; j < chunk; j++) {
+			phasesScalar(output, history + pos + (chunk - 1 - j), coeffs, taps, L);
+			output += L;
+		}
+		input += chunk * inputStride;
+		count -= chunk;
+	}
+}
+
+static void upsampleFoldedScalar(float *output, const float *input, size_t inputStride, size_t count,
+								 float *history, size_t &pos, const Polyphase::Filter &filter)
+{
+	while (count > 0) {
+		const size_t chunk = pushHistory<true>(history, pos, filter.taps, input, inputStride, count);
+		const float *newest = chronologicalNewest(history, pos, filter.taps, chunk);
+		for (size_t j = 0; j < chunk; j++) {
+			foldedPhasesScalar(output, history + pos + (chunk - 1 - j), newest + j, filter);
+			output += filter.L;
+		}
+		input += chunk * inputStride;
+		count -= chunk;
+	}
+}
+
+#ifdef SNDSCOPE_SSE2
+
+static inline float horizontalSum(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+	return _mm_cvtss_f32(v);
+}
+
+static inline void phasesSSE2(float *output, const float *window, const float *coeffs, size_t taps, int L)
+{
+	// 4 phases at a time, sharing window loads and reducing all 4 sums together
+	int k = 0;
+	for (; k + 4 <= L; k += 4) {
+		const float *c = coeffs + k * taps;
+		__m128 acc0 = _mm_setzero_ps();
+		__m128 acc1 = _mm_setzero_ps();
+		__m128 acc2 = _mm_setzero_ps();
+		__m128 acc3 = _mm_setzero_ps();
+		for (size_t i = 0; i < taps; i += 4) {
+			const __m128 w = _mm_loadu_ps(window + i);
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(w, _mm_loadu_ps(c + i)));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(w, _mm_loadu_ps(c + taps + i)));
+			acc2 = _mm_add_ps(acc2, _mm_mul_ps(w, _mm_loadu_ps(c + 2 * taps + i)));
+			acc3 = _mm_add_ps(acc3, _mm_mul_ps(w, _mm_loadu_ps(c + 3 * taps + i)));
+		}
+		_MM_TRANSPOSE4_PS(acc0, acc1, acc2, acc3);
+		_mm_storeu_ps(output + k, _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3)));
+	}
+
+	for (; k < L; k++) {
+		const float *c = coeffs + k * taps;
+		__m128 acc = _mm_setzero_ps();
+		for (size_t i = 0; i < taps; i += 4) {
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(window + i), _mm_loadu_ps(c + i)));
+		}
+		output[k] = horizontalSum(acc);
+	}
+}
+
+static void upsampleSSE2(float *output, const float *input, size_t inputStride, size_t count,
+						 float *history, size_t &pos, const Polyphase::Filter &filter)
+{
+	const float *coeffs = filter.coeffs;
+	const size_t taps = filter.taps;
+	const int L = filter.L;
+	while (count > 0) {
+		const size_t chunk = pushHistory<false>(history, pos, taps, input, inputStride, count);
+		for (size_t j = 0; j < chunk; j++) {
+			phasesSSE2(output, history + pos + (chunk - 1 - j), coeffs, taps, L);
+			output += L;
+		}
+		input += chunk * inputStride;
+		count -= chunk;
+	}
+}
+
+#endif // SNDSCOPE_SSE2
+
+#ifdef SNDSCOPE_AVX2
+
+SNDSCOPE_TARGET("avx2,fma")
+static inline void phasesAVX2(float *output, const float *window, const float *coeffs, size_t taps, int L)
+{
+
+	// 4 phases at a time, sharing window loads and reducing all 4 sums together
+	int k = 0;
+	for (; k + 4 <= L; k += 4) {
+		const float *c = coeffs + k * taps;
+		__m256 acc0 = _mm256_setzero_ps();
+		__m256 acc1 = _mm256_setzero_ps();
+		__m256 acc2 = _mm256_setzero_ps();
+		__m256 acc3 = _mm256_setzero_ps();
+		for (size_t i = 0; i < taps; i += 8) {
+			const __m256 w = _mm256_loadu_ps(window + i);
+			acc0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(c + i), acc0);
+			acc1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(c + taps + i), acc1);
+			acc2 = _mm256_fmadd_ps(w, _mm256_loadu_ps(c + 2 * taps + i), acc2);
+			acc3 = _mm256_fmadd_ps(w, _mm256_loadu_ps(c + 3 * taps + i), acc3);
+		}
+		const __m256 h = _mm256_hadd_ps(_mm256_hadd_ps(acc0, acc1), _mm256_hadd_ps(acc2, acc3));
+		_mm_storeu_ps(output + k, _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1)));
+	}
+
+	// then 2 at a time
+	for (; k + 2 <= L; k += 2) {
+		const float *c = coeffs + k * taps;
+		__m256 acc0 = _mm256_setzero_ps();
+		__m256 acc1 = _mm256_setzero_ps();
+		for (size_t i = 0; i < taps; i += 8) {
+			const __m256 w = _mm256_loadu_ps(window + i);
+			acc0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(c + i), acc0);
+			acc1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(c + taps + i), acc1);
+		}
+		const __m256 h = _mm256_hadd_ps(acc0, acc1);
+		__m128 v = _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1));
+		v = _mm_hadd_ps(v, v);
+		_mm_storel_pi(reinterpret_cast<__m64 *>(output + k), v);
+	}
+
+	for (; k < L; k++) {
+		const float *c = coeffs + k * taps;
+		__m256 acc = _mm256_setzero_ps();
+		for (size_t i = 0; i < taps; i += 8) {
+			acc = _mm256_fmadd_ps(_mm256_loadu_ps(window + i), _mm256_loadu_ps(c + i), acc);
+		}
+		output[k] = horizontalSum(_mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1)));
+	}
+}
+
+SNDSCOPE_TARGET("avx2,fma")
+static void upsampleAVX2(float *output, const float *input, size_t inputStride, size_t count,
+						 float *history, size_t &pos, const Polyphase::Filter &filter)
+{
+	const float *coeffs = filter.coeffs;
+	const size_t taps = filter.taps;
+	const int L = filter.L;
+	while (count > 0) {
+		const size_t chunk = pushHistory<false>(history, pos, taps, input, inputStride, count);
+		for (size_t j = 0; j < chunk; j++) {
+			phasesAVX2(output, history + pos + (chunk - 1 - j), coeffs, taps, L);
+			output += L;
+		}
+		input += chunk * inputStride;
+		count -= chunk;
+	}
+}
+
+#endif // SNDSCOPE_AVX2
+
+// function : for any filter
+// foldedFunction : for foldable filters (nullptr if folding doesn't pay off with this instruction set)
+struct UpsampleImplementation
+{
+	UpsampleFunction function;
+	UpsampleFunction foldedFunction;
+	const char *name;
+	const char *foldedName;
+};
+
+static const UpsampleImplementation &getImplementation()
+{
+	// (see CpuFeatures::select())
+	// Folding only pays off where multiplies are the bottleneck : with SIMD on x86, the extra adds (or loss of FMA),
+	// unaligned loads of the reversed operand, and one horizontal reduction per row cost more than the multiplies saved.
+	// So the folded form is used by the plain C++ implementation, ie on non-x86 builds (eg Apple Silicon)
+	static const UpsampleImplementation implementation = CpuFeatures::select<UpsampleImplementation>(
+		{upsampleScalar, upsampleFoldedScalar, "scalar", "scalar (folded)"},
+		SNDSCOPE_SSE2_IMPLEMENTATION(UpsampleImplementation{upsampleSSE2, nullptr, "SSE2", nullptr}),
+		SNDSCOPE_AVX2_IMPLEMENTATION(UpsampleImplementation{upsampleAVX2, nullptr, "AVX2/FMA", nullptr}),
+		true);
+	return implementation;
+}
+
+void Polyphase::upsample(float *output, const float *input, size_t inputStride, size_t count,
+						 float *history, size_t &pos, const Filter &filter)
+{
+	const UpsampleImplementation &implementation = getImplementation();
+	if (filter.foldable && implementation.foldedFunction != nullptr) {
+		implementation.foldedFunction(output, input, inputStride, count, history, pos, filter);
+	} else {
+		implementation.function(output, input, inputStride, count, history, pos, filter);
+	}
+}
+
+const char *Polyphase::implementation(const Filter &filter)
+{
+	const UpsampleImplementation &implementation = getImplementation();
+	return (filter.foldable && implementation.foldedFunction != nullptr) ? implementation.foldedName : implementation.name;
+}
@@ -0,0 +1,178 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef POLYPHASE_H
+#define POLYPHASE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// Polyphase : block-processing kernels for polyphase FIR interpolation (single precision).
+//
+// A prototype (lowpass) filter h of length N is split, at compile time (see design()), into L phases (sub-filters)
+// p_k[i] = L * h[i * L + k], so that output k (of L) for input x[t] is the sum of p_k[i] * x[t - i].
+// The phases are stored phase-major, in newest-sample-first order,
+// with each phase padded (with zeros) to a multiple of tapAlignment.
+//
+// When h is symmetric (linear phase), the design also includes a folded form, which needs about half the multiplies:
+// - a phase which is itself symmetric only needs half its coefficients, applied to x[t - i] + x[t - (n - 1 - i)]
+// - any other phase is the mirror image of some other phase k'; together, they need the same number of multiplies
+//   as one phase : a sum row (applied to x[t - i] + x[t - (n - 1 - i)]) gives (y_k + y_k') / 2,
+//   and a difference row (applied to x[t - i] - x[t - (n - 1 - i)]) gives (y_k - y_k') / 2
+//
+// The history is a double-length buffer of 2 * taps samples, filled from the top down (newest sample at history + pos),
+// so that the most recent 'taps' samples are always available as one contiguous window, with no wrap-around.
+// Each output is then a straight dot product of the window with one phase of the filter.
+// When the buffer is used up, the last (taps - 1) samples are slid back up to the top (once every taps + 1 samples).
+// The folded form also needs the samples in chronological order, so (when folding) a second double-length buffer is kept
+// (filled from the bottom up) directly after the first. A fresh history is all zeros, with pos = taps.
+//
+// The best available implementation (AVX2/FMA, SSE2 or plain C++) is selected at run-time,
+// along with whichever form (folded or not) runs fastest with it (only plain C++, ie non-x86 builds, uses the folded form)
+
+class Polyphase
+{
+public:
+	static constexpr size_t tapAlignment = 8;
+	static constexpr size_t foldedTapAlignment = 4;
+	static constexpr int maxL = 16;
+	static constexpr double symmetryTolerance = 1.0e-12; // (allows for rounding in published coefficient tables)
+
+	enum RowType
+	{
+		Symmetric,
+		PairSum,
+		PairDifference
+	};
+
+	struct FoldedRow
+	{
+		RowType type{Symmetric};
+		int length{0}; // length of (unfolded) phase
+		int output{0}; // phase index
+		int partner{0}; // phase index of mirror-image phase (pairs only)
+	};
+
+	// Filter : a polyphase decomposition, as used by upsample()
+	struct Filter
+	{
+		int L;
+		size_t prototypeLength;
+		size_t taps; // per phase
+		const float *coeffs; // L * taps
+		bool foldable; // (prototype is symmetric, and there are enough phases, long enough, to be worth folding)
+		size_t foldedTaps; // per row
+		const float *foldedCoeffs; // numRows * foldedTaps
+		const FoldedRow *rows;
+		int numRows;
+
+		constexpr size_t historyLength() const
+		{
+			return 4 * taps + foldedTaps;
+		}
+	};
+
+	template<int L, size_t N>
+	struct Design
+	{
+		static_assert(L >= 1 && L <= maxL, "unsupported upsampling factor");
+
+		static constexpr size_t phaseLength = (N + L - 1) / L;
+		static constexpr size_t taps = (phaseLength + tapAlignment - 1) / tapAlignment * tapAlignment;
+		static constexpr size_t foldedTaps = ((phaseLength + 1) / 2 + foldedTapAlignment - 1) / foldedTapAlignment * foldedTapAlignment;
+
+		std::array<float, L * taps> coeffs{};
+		std::array<float, L * foldedTaps> foldedCoeffs{};
+		std::array<FoldedRow, L> rows{};
+		int numRows{0};
+		bool symmetric{true};
+
+		constexpr Filter filter() const
+		{
+			// (at L = 2, both phases are symmetric rows, and folding them measured slower than not)
+			return {L, N, taps, coeffs.data(), symmetric && L > 2 && phaseLength > 1, foldedTaps, foldedCoeffs.data(), rows.data(), numRows};
+		}
+	};
+
+	// decompose prototype filter (at compile time)
+	template<int L, size_t N>
+	static constexpr Design<L, N> design(const std::array<double, N> &prototype)
+	{
+		using D = Design<L, N>;
+		D d{};
+
+		double peak = 0.0;
+		for (size_t m = 0; m < N; m++) {
+			peak = (prototype[m] < 0.0) ? std::max(peak, -prototype[m]) : std::max(peak, prototype[m]);
+		}
+		for (size_t m = 0; m < N; m++) {
+			const double asymmetry = prototype[m] - prototype[N - 1 - m];
+			if (asymmetry > symmetryTolerance * peak || -asymmetry > symmetryTolerance * peak) {
+				d.symmetric = false;
+			}
+		}
+
+		for (int k = 0; k < L; k++) {
+			for (size_t i = 0; i * L + k < N; i++) {
+				d.coeffs[k * D::taps + i] = static_cast<float>(L * prototype[i * L + k]);
+			}
+		}
+
+		if (!d.symmetric) {
+			return d;
+		}
+
+		std::array<bool, L> done{};
+		for (int k = 0; k < L; k++) {
+			if (done[k]) {
+				continue;
+			}
+
+			const int length = static_cast<int>((N - 1 - k) / L + 1);
+			const int mirror = static_cast<int>((N - 1 - k) % L); // p_mirror[i] == p_k[length - 1 - i]
+			const bool odd = (length % 2) != 0;
+			const int middle = length / 2;
+
+			if (mirror == k) {
+				const int r = d.numRows++;
+				d.rows[r] = {Symmetric, length, k, k};
+				for (int i = 0; i < (length + 1) / 2; i++) {
+					const double c = L * prototype[i * L + k];
+					d.foldedCoeffs[r * D::foldedTaps + i] = static_cast<float>((odd && i == middle) ? 0.5 * c : c);
+				}
+			} else {
+				const int r = d.numRows;
+				d.numRows += 2;
+				d.rows[r] = {PairSum, length, k, mirror};
+				d.rows[r + 1] = {PairDifference, length, k, mirror};
+				for (int i = 0; i < (length + 1) / 2; i++) {
+					const double a = L * prototype[i * L + k];
+					const double b = L * prototype[(length - 1 - i) * L + k];
+					d.foldedCoeffs[r * D::foldedTaps + i] = static_cast<float>((odd && i == middle) ? 0.5 * a : 0.5 * (a + b));
+					d.foldedCoeffs[(r + 1) * D::foldedTaps + i] = static_cast<float>(0.5 * (a - b));
+				}
+				done[mirror] = true;
+			}
+			done[k] = true;
+		}
+
+		return d;
+	}
+
+	// upsample 'count' samples from input (taking every inputStride'th sample), writing count * L samples to output.
+	// history : filter.historyLength() floats
+	static void upsample(float *output, const float *input, size_t inputStride, size_t count,
+						 float *history, size_t &pos, const Filter &filter);
+
+	// name of implementation in use
+	static const char *implementation(const Filter &filter);
+};
+
+#endif // POLYPHASE_H
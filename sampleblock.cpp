@@ -0,0 +1,124 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "sampleblock.h"
+
+#include <cassert>
+#include <new>
+
+void SampleBlockReleaser::operator()(SampleBlock *block) const
+{
+	if (block != nullptr) {
+		block->pool->release(block);
+	}
+}
+
+SampleBlockPool::~SampleBlockPool()
+{
+	freeStorage();
+}
+
+void SampleBlockPool::allocate(int numBlocks, int numChannels, int64_t framesPerChannel)
+{
+	assert(blocksInUse.load() == 0);
+	freeStorage();
+
+	// round channel length up to a whole number of cache lines
+	constexpr int64_t floatsPerLine = SampleBlock::alignment / sizeof(float);
+	const int64_t stride = (framesPerChannel + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+	const int64_t floatsPerBlock = stride * numChannels;
+
+	storageBytes = numBlocks * floatsPerBlock * sizeof(float);
+	storage = static_cast<float *>(::operator new(storageBytes, std::align_val_t{SampleBlock::alignment}));
+
+	blocks.resize(numBlocks);
+	SampleBlock *next = nullptr;
+	for (int i = numBlocks - 1; i >= 0; i--) {
+		SampleBlock &block = blocks[i];
+		block.data = storage + i * floatsPerBlock;
+		block.stride = stride;
+		block.pool = this;
+		block.frames = 0ll;
+		block.nextFree = next;
+		next = &block;
+	}
+
+	freeList.store(next, std::memory_order_release);
+	resetCounters();
+}
+
+SampleBlockPtr SampleBlockPool::acquire()
+{
+	SampleBlock *head = freeList.load(std::memory_order_acquire);
+
+	// pop : safe from ABA, because only one thread ever pops
+	while (head != nullptr && !freeList.compare_exchange_weak(head, head->nextFree, std::memory_order_acquire, std::memory_order_acquire)) {
+	}
+
+	if (head == nullptr) {
+		exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	const int n = blocksInUse.fetch_add(1, std::memory_order_relaxed) + 1;
+	int peak = peakBlocksInUse.load(std::memory_order_relaxed);
+	while (n > peak && !peakBlocksInUse.compare_exchange_weak(peak, n, std::memory_order_relaxed)) {
+	}
+
+	head->frames = 0ll;
+	return SampleBlockPtr{head};
+}
+
+void SampleBlockPool::release(SampleBlock *block)
+{
+	// push
+	SampleBlock *head = freeList.load(std::memory_order_relaxed);
+	do {
+		block->nextFree = head;
+	} while (!freeList.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+
+	blocksInUse.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void SampleBlockPool::freeStorage()
+{
+	if (storage != nullptr) {
+		::operator delete(storage, std::align_val_t{SampleBlock::alignment});
+		storage = nullptr;
+		storageBytes = 0;
+	}
+	blocks.clear();
+	freeList.store(nullptr, std::memory_order_relaxed);
+}
+
+int SampleBlockPool::getBlockCount() const
+{
+	return static_cast<int>(blocks.size());
+}
+
+int SampleBlockPool::getBlocksInUse() const
+{
+	return blocksInUse.load(std::memory_order_relaxed);
+}
+
+int SampleBlockPool::getPeakBlocksInUse() const
+{
+	return peakBlocksInUse.load(std::memory_order_relaxed);
+}
+
+int64_t SampleBlockPool::getExhaustedCount() const
+{
+	return exhaustedCount.load(std::memory_order_relaxed);
+}
+
+void SampleBlockPool::resetCounters()
+{
+	peakBlocksInUse.store(blocksInUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	exhaustedCount.store(0ll, std::memory_order_relaxed);
+}
@@ -0,0 +1,106 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef SAMPLEBLOCK_H
+#define SAMPLEBLOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class SampleBlockPool;
+
+// SampleBlock : fixed-size block of planar (de-interleaved) samples.
+// Each channel starts on a 64-byte boundary.
+// Blocks are owned by a SampleBlockPool, and are lent out via SampleBlockPtr
+
+struct SampleBlock
+{
+	static constexpr size_t alignment = 64;
+
+	int64_t startFrame{0ll}; // position in file of first (input) frame
+	int64_t frames{0ll}; // number of frames per channel in use
+	int upsampleFactor{1}; // frames per input frame
+
+	float *channel(int ch)
+	{
+		return data + ch * stride;
+	}
+
+	const float *channel(int ch) const
+	{
+		return data + ch * stride;
+	}
+
+	int64_t capacity() const
+	{
+		return stride;
+	}
+
+private:
+	friend class SampleBlockPool;
+	friend struct SampleBlockReleaser;
+	float *data{nullptr};
+	int64_t stride{0ll}; // distance (in floats) between channels
+	SampleBlockPool *pool{nullptr};
+	SampleBlock *nextFree{nullptr};
+};
+
+// SampleBlockReleaser : returns a SampleBlock to its pool, instead of deleting it
+
+struct SampleBlockReleaser
+{
+	void operator()(SampleBlock *block) const;
+};
+
+using SampleBlockPtr = std::unique_ptr<SampleBlock, SampleBlockReleaser>;
+
+// SampleBlockPool : recycles a fixed number of SampleBlocks, with no heap allocations after allocate().
+// acquire() may only be called from one thread at a time, but blocks may be released from any thread.
+
+class SampleBlockPool
+{
+public:
+	SampleBlockPool() = default;
+	SampleBlockPool(const SampleBlockPool&) = delete;
+	SampleBlockPool& operator=(const SampleBlockPool&) = delete;
+	~SampleBlockPool();
+
+	// (re)allocate storage. All blocks must have been returned.
+	void allocate(int numBlocks, int numChannels, int64_t framesPerChannel);
+
+	// returns nullptr (and counts an exhaustion event) if no blocks are free
+	SampleBlockPtr acquire();
+
+	// counters
+	int getBlockCount() const;
+	int getBlocksInUse() const;
+	int getPeakBlocksInUse() const;
+	int64_t getExhaustedCount() const;
+	void resetCounters();
+
+private:
+	friend struct SampleBlockReleaser;
+
+	std::vector<SampleBlock> blocks;
+	float *storage{nullptr};
+	size_t storageBytes{0};
+
+	std::atomic<SampleBlock *> freeList{nullptr};
+	std::atomic<int> blocksInUse{0};
+	std::atomic<int> peakBlocksInUse{0};
+	std::atomic<int64_t> exhaustedCount{0ll};
+
+	void release(SampleBlock *block);
+	void freeStorage();
+};
+
+#endif // SAMPLEBLOCK_H
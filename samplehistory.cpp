@@ -0,0 +1,64 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "samplehistory.h"
+
+#include <algorithm>
+
+void SampleHistory::allocate(int newNumChannels, int64_t minCapacityFrames)
+{
+	capacityFrames = 1;
+	while (capacityFrames < minCapacityFrames) {
+		capacityFrames <<= 1;
+	}
+
+	mask = capacityFrames - 1;
+	buffers.assign(static_cast<size_t>(newNumChannels), std::vector<float>(static_cast<size_t>(capacityFrames), 0.0f));
+	oldest = tail;
+}
+
+int SampleHistory::getNumChannels() const
+{
+	return static_cast<int>(buffers.size());
+}
+
+int64_t SampleHistory::getCapacityFrames() const
+{
+	return capacityFrames;
+}
+
+int64_t SampleHistory::writePosition() const
+{
+	return tail;
+}
+
+int64_t SampleHistory::oldestPosition() const
+{
+	return oldest;
+}
+
+void SampleHistory::write(const float *const *channels, int64_t frames)
+{
+	// (if there are more frames than will fit, only the last capacityFrames of them are kept)
+	const int64_t skip = std::max<int64_t>(0ll, frames - capacityFrames);
+	const int64_t t = tail + skip;
+	const int64_t n = frames - skip;
+
+	// copy in (up to) two pieces, either side of the wrap-around point
+	const int64_t first = std::min(n, capacityFrames - (t & mask));
+	for (size_t ch = 0; ch < buffers.size(); ch++) {
+		const float *in = channels[ch] + skip;
+		float *buffer = buffers[ch].data();
+		std::copy_n(in, first, buffer + (t & mask));
+		std::copy_n(in + first, n - first, buffer);
+	}
+
+	tail += frames;
+	oldest = std::max(oldest, tail - capacityFrames);
+}
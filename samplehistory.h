@@ -0,0 +1,49 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef SAMPLEHISTORY_H
+#define SAMPLEHISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// SampleHistory : the most recent frames of each channel, kept in a (planar) ring per channel.
+// As with AudioRing, positions count frames from the start of the stream, so a frame can be looked up
+// by its position for as long as it remains in the ring. Unlike AudioRing, writing never blocks :
+// the oldest frames are simply overwritten. Not thread-safe (it belongs to whichever thread writes to it)
+
+class SampleHistory
+{
+public:
+	// (clears the history, but positions carry on)
+	void allocate(int newNumChannels, int64_t minCapacityFrames);
+	int getNumChannels() const;
+	int64_t getCapacityFrames() const;
+
+	int64_t writePosition() const; // (position of next frame to be written)
+	int64_t oldestPosition() const; // (position of oldest frame held)
+
+	// append frames (one pointer per channel)
+	void write(const float *const *channels, int64_t frames);
+
+	float at(int ch, int64_t position) const
+	{
+		return buffers[static_cast<size_t>(ch)][static_cast<size_t>(position & mask)];
+	}
+
+private:
+	std::vector<std::vector<float>> buffers;
+	int64_t capacityFrames{0ll}; // always a power of 2
+	int64_t mask{0ll};
+	int64_t tail{0ll};
+	int64_t oldest{0ll};
+};
+
+#endif // SAMPLEHISTORY_H
@@ -13,6 +13,7 @@
 #include <QEvent>
 #include <QVBoxLayout>
 
+#include <algorithm>
 #include <cmath>
 
 ScopeWidget::ScopeWidget(QWidget *parent)
@@ -20,12 +21,18 @@ ScopeWidget::ScopeWidget(QWidget *parent)
 {
     scopeDisplay = new ScopeDisplay(this);
 	audioController = new AudioController(this);
+	audioRingDevice = new AudioRingDevice(&audioRing, this);
 	plotter = new Plotter;
+	decoder = new Decoder;
 
 	plotter->moveToThread(&renderThread);
 	connect(&renderThread, &QThread::finished, plotter, &QObject::deleteLater);
 	renderThread.start();
 
+	decoder->moveToThread(&decodeThread);
+	connect(&decodeThread, &QThread::finished, decoder, &QObject::deleteLater);
+	decodeThread.start();
+
 	auto mainLayout = new QVBoxLayout;
 	screenLayout = new QHBoxLayout;
 
@@ -45,35 +52,26 @@ ScopeWidget::ScopeWidget(QWidget *parent)
 
 	setUpsampling(getUpsampling());
 
+	scopeDisplay->getSwapChain()->resize(scopeDisplay->getSwapChain()->size(), backgroundColor);
+	plotter->setBackgroundColor(backgroundColor);
 	plotter->setTimeLimit_ms(plotInterval);
+	plotter->setSwapChain(scopeDisplay->getSwapChain());
 	plotter->setSweepParameters(sweepParameters);
 
-#ifdef SNDSCOPE_BLEND2D
-	scopeDisplay->getBlImageWrapper()->getQImage()->fill(backgroundColor);
-	plotter->setBlImageWrapper(scopeDisplay->getBlImageWrapper());
-#else
-	scopeDisplay->getPixmap()->fill(backgroundColor);
-	plotter->setTimeLimit_ms(plotInterval);
-	plotter->setPixmap(scopeDisplay->getPixmap());
-	plotter->setSweepParameters(sweepParameters);
-#endif
-
-    connect(scopeDisplay, &ScopeDisplay::pixmapResolutionChanged, this, [this](){
-
-#ifdef SNDSCOPE_BLEND2D
-		const auto b = scopeDisplay->getBlImageWrapper();
-		plotter->setBlImageWrapper(b);
-		w = b->getQImage()->width();
-		h = b->getQImage()->height();
-#else
-		const auto p = scopeDisplay->getPixmap();
-		plotter->setPixmap(p);
-		w = p->width();
-		h = p->height();
-#endif
+	// the display must not resize its swap chain while the plotter is drawing on it
+	connect(scopeDisplay, &ScopeDisplay::resolutionAboutToChange, this, &ScopeWidget::waitForRenderThread);
+
+    connect(scopeDisplay, &ScopeDisplay::resolutionChanged, this, [this](){
+
+		const QSize size = scopeDisplay->getSwapChain()->size();
+		w = size.width();
+		h = size.height();
 
 		sweepParameters.setWidthFrameRate(w, audioFramesPerMs);
-		plotter->calcScaling();
+		postToPlotter([this]{
+			plotter->calcScaling();
+		});
+		updateUpsampleFactor();
 	});
 
 	connect(&plotTimer, &QTimer::timeout, this, [this]{
@@ -81,21 +79,34 @@ ScopeWidget::ScopeWidget(QWidget *parent)
 
 			readInput();
 
-			// send audio to output
-			pushOut->write(reinterpret_cast<char*>(rawinputBuffer.data()), framesRead * audioFormat.bytesPerFrame());
+			// hand over to render thread; if the renderer is still busy, keep what we have and add to it next time
+			renderJob.currentFrame = currentFrame;
+			if (!plotter->submit(renderJob)) {
+				++coalescedJobs;
+			}
 
-			// plot it
-			plotter->render(inputBuffers, framesAvailable, currentFrame);
+			if (++metricsCountdown >= metricsInterval) {
+				metricsCountdown = 0;
+				const double avOffset_ms = audioClock.msFromFrames(currentPosition - audioClock.audiblePosition());
+				emit clockMetrics(avOffset_ms, audioClock.getDrift_ppm());
+			}
 		}
 	});
 
     connect(&screenUpdateTimer, &QTimer::timeout, this, [this] {
-        if (!paused) {
-			if (plotter->getFreshRender()) {
-				scopeDisplay->update();
-				plotter->setFreshRender(false);
-            }
-        }
+		if (scopeDisplay->getSwapChain()->hasFreshFrame()) {
+			scopeDisplay->update();
+		}
+
+		constexpr bool debugFrameStats = false;
+		if constexpr(debugFrameStats) {
+			static int n = 0;
+			if (++n % 1000 == 0) {
+				const FrameStats stats = getFrameStats();
+				qDebug() << "frames rendered:" << stats.rendered << "presented:" << stats.presented << "skipped:" << stats.skipped
+						 << "coalesced jobs:" << getCoalescedJobs();
+			}
+		}
     });
 
 	connect(audioController, &AudioController::outputVolume, this, [this](qreal linearVol){
@@ -120,6 +131,8 @@ ScopeWidget::~ScopeWidget()
 	qDebug().noquote() << "Goodbye";
 	renderThread.quit();
 	renderThread.wait();
+	decodeThread.quit();
+	decodeThread.wait();
 	qDebug().noquote() << "See you next time";
 }
 
@@ -132,21 +145,35 @@ QPair<bool, QString> ScopeWidget::loadSoundFile(const QString& filename)
 		// set up rendering parameters, based on soundfile properties
 		numInputChannels = sndfile->channels();
 
-		// initialize raw (interleaved) input buffer
-		rawinputBuffer.resize(numInputChannels * sndfile->samplerate()); // 1s of storage
+		// stop decoding and rendering, and get back all sample blocks, before resizing the pool
+		QMetaObject::invokeMethod(decoder, [this]{
+			decoder->close();
+		}, Qt::BlockingQueuedConnection);
+		QMetaObject::invokeMethod(plotter, [this]{
+			plotter->clearJobs();
+		}, Qt::BlockingQueuedConnection);
+		renderJob.clear();
+		clearPendingBlocks();
 
-		// initialize channel input buffers
-		inputBuffers.resize(numInputChannels);
-		for (int ch = 0; ch < numInputChannels; ch++) {
-			size_t chbufSize = sndfile->samplerate() * upsampleFactor; // allow for upsampling
-			inputBuffers[ch].resize(chbufSize);
-		}
+		constexpr int poolBlocks = Decoder::ringCapacity + pendingCapacity + (Plotter::jobQueueCapacity + 1) * RenderJob::maxBlocks;
+		samplePool.allocate(poolBlocks, numInputChannels, Decoder::sampleBlockFrames(sndfile->samplerate()));
+
+		// (the sound card pulls audio from audioRing, which is kept filled by the decoder)
+		audioController->stop();
+		audioRing.allocate(numInputChannels, audioRingDuration_ms * sndfile->samplerate() / 1000);
+
+		// hand file over to decoder thread (which does all seeking and reading from now on)
+		QMetaObject::invokeMethod(decoder, [this]{
+			decoder->setSource(*sndfile, &samplePool, &audioRing);
+		}, Qt::BlockingQueuedConnection);
 
-		audioFramesPerMs = sndfile->samplerate() / 1000;
+		audioClock.setSampleRate(sndfile->samplerate());
+		audioFramesPerMs = sndfile->samplerate() / 1000.0;
 		msPerAudioFrame = 1000.0 / sndfile->samplerate();
 		sweepParameters.setInputFrames_per_ms(audioFramesPerMs);
-		expectedFrames = plotTimer.interval() * audioFramesPerMs;
-		maxFramesToRead = rawinputBuffer.size() / sndfile->channels();
+		sweepParameters.inputChannels = numInputChannels;
+		expectedFrames = audioClock.framesFromMs(plotTimer.interval());
+		updateUpsampleFactor();
 
 		totalFrames = sndfile->frames();
 		returnToStart();
@@ -156,11 +183,16 @@ QPair<bool, QString> ScopeWidget::loadSoundFile(const QString& filename)
 		audioFormat.setChannelCount(sndfile->channels());
 		audioFormat.setSampleFormat(QAudioFormat::Float);
 		audioController->initializeAudio(audioFormat, outputDeviceInfo);
+		if (!paused) {
+			setPaused(false); // resume playing (new file)
+		}
 
-		plotter->setExpectedFrames(expectedFrames);
-		plotter->setAudioFramesPerMs(audioFramesPerMs);
-		plotter->setNumInputChannels(audioFormat.channelCount());
-		plotter->calcScaling();
+		postToPlotter([this, e = expectedFrames, f = audioFramesPerMs, c = numInputChannels]{
+			plotter->setExpectedFrames(e);
+			plotter->setAudioFramesPerMs(f);
+			plotter->setNumInputChannels(c);
+			plotter->calcScaling();
+		});
 
 		emit loadedFile();
 	}
@@ -187,32 +219,47 @@ void ScopeWidget::setPaused(bool value)
 
 	paused = value;
 	if (!paused) {
-		pushOut=audioController->start();
-		startFrame = currentFrame;
-		elapsedTimer.restart();
+		audioController->start(audioRingDevice);
+		audioClock.start(audioController, &audioRing);
 	} else {
 		audioController->stop();
+
+		// audio taken from the ring ahead of the playhead has been dropped by the sound card (and the blocks waiting
+		// for it would be rendered all at once on resume) : go back and pick it up again
+		if (fileLoaded && audioRing.readPosition() > currentPosition) {
+			seek(currentFrame);
+		}
 	}
 }
 
 void ScopeWidget::returnToStart()
 {
-	elapsedTimer.restart();
-	currentFrame = 0ll;
-	startFrame = 0ll;
-
 	if (sndfile != nullptr && !sndfile->error()) {
-		sndfile->seek(0ll, SEEK_SET);
+		seek(0ll);
 	}
 }
 
 void ScopeWidget::gotoPosition(int64_t milliSeconds)
 {
-	elapsedTimer.restart();
 	if (sndfile != nullptr && !sndfile->error()) {
-		currentFrame = audioFramesPerMs * milliSeconds;
-		startFrame = currentFrame;
-		sndfile->seek(qMin(currentFrame, sndfile->frames()), SEEK_SET);
+		seek(qMin(audioClock.framesFromMs(milliSeconds), sndfile->frames()));
+	}
+}
+
+void ScopeWidget::seek(int64_t frame)
+{
+	// (the decoder also discards any audio it has queued up from the old position)
+	currentFrame = frame;
+	clearPendingBlocks();
+	decoder->requestSeek(frame);
+}
+
+void ScopeWidget::clearPendingBlocks()
+{
+	// return held samples to the pool
+	pendingBlocks.reset();
+	for (size_t i = 0; i < pendingBlocks.capacity(); i++) {
+		pendingBlocks.slot(i).samples.reset();
 	}
 }
 
@@ -224,22 +271,25 @@ QColor ScopeWidget::getBackgroundColor() const
 void ScopeWidget::setBackgroundColor(const QColor &value)
 {
 	backgroundColor = value;
+	postToPlotter([this, b = backgroundColor]{
+		plotter->setBackgroundColor(b);
+	});
 }
 
-void ScopeWidget::setPhosporColors(const QVector<QColor>& colors)
+void ScopeWidget::setPhosphor(const Phosphor &newPhosphor)
 {
-	if (!colors.isEmpty()) {
-		plotter->setPhosphorColor(colors.at(0));
-		if (colors.count() > 1) {
-			plotter->setCompositionMode(QPainter::CompositionMode_HardLight);
-			plotter->setDarkencolor(colors.at(1));
-		} else {
-			plotter->setCompositionMode(QPainter::CompositionMode_SourceOver);
-			plotter->setDarkencolor(backgroundColor);
-		}
+	if (!newPhosphor.layers.isEmpty()) {
+		phosphor = newPhosphor;
+		phosphorColor = phosphor.layers.at(0).color;
+		updatePhosphorLayers();
 	}
 }
 
+Phosphor ScopeWidget::getPhosphor() const
+{
+	return phosphor;
+}
+
 double ScopeWidget::getPersistence() const
 {
 	return persistence;
@@ -249,30 +299,34 @@ void ScopeWidget::setPersistence(double time_ms)
 {
 	// qDebug() << QStringLiteral("setting persistence to %1").arg(time_ms);
 	persistence = time_ms;
+	updatePhosphorLayers();
+}
 
+void ScopeWidget::updatePhosphorLayers()
+{
 	// define fraction of original brightness
 	constexpr double decayTarget = 0.2;
 
-	// set minimum darkening amount threshold. (If the darkening amount is too low, traces will never completely disappear)
-	constexpr qreal minDarkenAlpha = 32;
+	// persistence setting applies to the first layer; the other layers keep their persistence relative to it
+	const double firstLayerPersistence = std::max(1.0, phosphor.layers.at(0).persistence);
+
+	QVector<BeamRasteriser::Layer> layers;
+	for (const PhosphorLayer &phosphorLayer : std::as_const(phosphor.layers)) {
+		const double time_ms = persistence * phosphorLayer.persistence / firstLayerPersistence;
 
-	int darkenAlpha = 0;
-	int  darkenNthFrame = 0;
-	do {
-		++darkenNthFrame; // for really long persistence, darkening operation may need to occur less often than once per frame
-		double n = std::max(1.0, time_ms / plotTimer.interval()) / darkenNthFrame; // number of frames to reach decayTarget (can't be zero)
-		darkenAlpha = std::min(std::max(1, static_cast<int>(255 * (1.0 - std::pow(decayTarget, (1.0 / n))))), 255);
-	} while (darkenAlpha < minDarkenAlpha);
+		// trace intensity decays continuously (the plotter works in floating-point, so even very slow decay rates eventually fade out)
+		const double n = std::max(1.0, time_ms / plotTimer.interval()); // number of frames to reach decayTarget (can't be zero)
+		layers.append({phosphorLayer.color, std::pow(decayTarget, 1.0 / n)});
+	}
 
-	auto darkenColor = plotter->getDarkencolor();
-	darkenColor.setAlpha(darkenAlpha);
-	plotter->setDarkencolor(darkenColor);
-	plotter->setDarkenNthFrame(darkenNthFrame);
+	postToPlotter([this, layers]{
+		plotter->setPhosphorLayers(layers);
+	});
 }
 
 QColor ScopeWidget::getPhosphorColor() const
 {
-	return plotter->getPhosphorColor();
+	return phosphorColor;
 }
 
 double ScopeWidget::getFocus() const
@@ -284,10 +338,12 @@ void ScopeWidget::setFocus(double value)
 {
 	constexpr double maxBeamWidth = 12;
 	focus = value;
-	plotter->setBeamWidth(qMax(0.5, (1.0 - (focus * 0.01)) * maxBeamWidth));
-	const auto beamWidth = plotter->getBeamWidth();
-	plotter->setBeamIntensity(8.0 / (beamWidth * beamWidth));
-	calcBeamAlpha();
+	beamWidth = qMax(0.5, (1.0 - (focus * 0.01)) * maxBeamWidth);
+
+	// (kernels are built here, rather than on the render thread)
+	postToPlotter([this, kernel = BeamKernel::get(beamWidth)]{
+		plotter->setBeamKernel(kernel);
+	});
 }
 
 double ScopeWidget::getBrightness() const
@@ -298,15 +354,19 @@ double ScopeWidget::getBrightness() const
 void ScopeWidget::setBrightness(double value)
 {
 	brightness = value;
-	calcBeamAlpha();
+	calcBeamEnergy();
 }
 
-void ScopeWidget::calcBeamAlpha()
+void ScopeWidget::calcBeamEnergy()
 {
-	beamAlpha = qMin(1.27 * brightness * plotter->getBeamIntensity(), 255.0);
-	auto phosphorColor = plotter->getPhosphorColor();
-	phosphorColor.setAlpha(beamAlpha);
-	plotter->setPhosphorColor(phosphorColor);
+	// total energy of one sample, which the beam kernel spreads over the spot
+	// (so focussing makes the spot smaller and brighter, as on a real CRT).
+	// Not clamped : the plotter accumulates intensity, and saturates it smoothly when converting to colour
+	constexpr double energyPerBrightness = 0.045;
+	beamEnergy = energyPerBrightness * brightness;
+	postToPlotter([this, e = beamEnergy]{
+		plotter->setBeamEnergy(e);
+	});
 }
 
 int64_t ScopeWidget::getTotalFrames() const
@@ -316,54 +376,92 @@ int64_t ScopeWidget::getTotalFrames() const
 
 void ScopeWidget::readInput()
 {
-	// estimate how far ahead to read
-	const int64_t toFrame = qMin(totalFrames - 1, startFrame + static_cast<int64_t>(elapsedTimer.elapsed() * audioFramesPerMs));
+	// the decoder has already queued each block's audio for output; the audio clock tells us which
+	// (stream) position is being heard right now, and samples are only handed to the renderer once they are audible
+	int64_t audiblePosition = audioClock.audiblePosition();
+
+	// with no audio output running, nobody else is draining the audio ring : do it here, in real time.
+	// (if it runs dry, carry on from where it is, just like a sound card playing silence would)
+	if (!audioController->isActive()) {
+		audioRing.skipTo(audiblePosition);
+		if (audioRing.readPosition() < audiblePosition) {
+			audioClock.start(audioController, &audioRing);
+			audiblePosition = audioRing.readPosition();
+		}
+	}
 
-	// read from file
-	framesRead = sndfile->readf(rawinputBuffer.data(), qMin(maxFramesToRead, toFrame - currentFrame));
-	currentFrame += framesRead;
+	framesRead = 0ll;
 
-	constexpr bool debugExpectedFrames = false;
-	if constexpr(debugExpectedFrames) {
-		if (framesRead > expectedFrames)
-			qDebug() << "expected" << expectedFrames << "got" << framesRead;
+	// collect already-decoded blocks
+	const DecodedBlock *block = decoder->front();
+	PendingBlock *pending = pendingBlocks.writeSlot();
+	while (block != nullptr && pending != nullptr) {
+		pending->endFrame = block->startFrame + block->framesRead;
+		pending->endPosition = block->streamPosition + block->framesRead;
+		pending->samples = std::move(block->samples);
+		pendingBlocks.commitWrite();
+
+		decoder->pop();
+		block = decoder->front();
+		pending = pendingBlocks.writeSlot();
 	}
 
-	// de-interleave
-	if (upsampling && numInputChannels <= 2) {
-		if (numInputChannels == 1) {
-			upsampler.upsampleBlockMono(inputBuffers[0].data(), rawinputBuffer.constData(), framesRead);
-			framesAvailable = framesRead * upsampleFactor;
-		} else if (numInputChannels == 2) {
-			upsampler.upsampleBlockStereo(inputBuffers[0].data(), inputBuffers[1].data(), rawinputBuffer.constData(), framesRead);
-			framesAvailable = framesRead * upsampleFactor;
+	// pass ownership of audible samples to render job
+	for (pending = pendingBlocks.readSlot(); pending != nullptr && pending->endPosition <= audiblePosition; pending = pendingBlocks.readSlot()) {
+
+		// if render job is full (renderer fell behind), keep only the most recent half of it.
+		// (The plotter only ever plots the most recent frames anyway)
+		if (renderJob.numBlocks == RenderJob::maxBlocks) {
+			constexpr int keep = RenderJob::maxBlocks / 2;
+			std::move(renderJob.blocks.begin() + keep, renderJob.blocks.end(), renderJob.blocks.begin());
+			renderJob.numBlocks = keep;
 		}
-	} else {
-		for (int64_t f = 0ll; f < framesRead; f++) {
-			for (int ch = 0; ch < numInputChannels; ch++) {
-				inputBuffers[ch][f] = rawinputBuffer[f * numInputChannels + ch];
-			}
+
+		framesRead += pending->endFrame - pending->samples->startFrame;
+		renderJob.blocks[renderJob.numBlocks++] = std::move(pending->samples);
+		currentFrame = pending->endFrame;
+		currentPosition = pending->endPosition;
+		pendingBlocks.commitRead();
+	}
+
+	constexpr bool debugClock = false;
+	if constexpr(debugClock) {
+		static int n = 0;
+		if (++n % 100 == 0) {
+			qDebug() << "audible:" << audiblePosition << "rendering:" << currentPosition << "queued:" << audioRing.availableFrames()
+					 << "underruns:" << audioRingDevice->getUnderrunFrames() << "drift:" << audioClock.getDrift_ppm() << "ppm";
+		}
+	}
+
+	constexpr bool debugUnderrun = false;
+	if constexpr(debugUnderrun) {
+		if (pendingBlocks.size() == 0 && currentFrame < totalFrames) {
+			qDebug() << "decoder underrun at frame" << currentFrame;
+		}
+	}
+
+	constexpr bool debugSamplePool = false;
+	if constexpr(debugSamplePool) {
+		static int64_t lastExhaustedCount = 0ll;
+		if (samplePool.getExhaustedCount() != lastExhaustedCount) {
+			lastExhaustedCount = samplePool.getExhaustedCount();
+			qDebug() << "sample pool exhausted" << lastExhaustedCount << "times; peak usage"
+					 << samplePool.getPeakBlocksInUse() << "of" << samplePool.getBlockCount() << "blocks";
 		}
-		framesAvailable = framesRead;
+	}
+
+	constexpr bool debugExpectedFrames = false;
+	if constexpr(debugExpectedFrames) {
+		if (framesRead > expectedFrames)
+			qDebug() << "expected" << expectedFrames << "got" << framesRead;
 	}
 }
 
 void ScopeWidget::wipeScreen()
 {
-#ifdef SNDSCOPE_BLEND2D
-	// todo: wipe screen
-#else
-	auto pixmap = scopeDisplay->getPixmap();
-    QPainter painter(pixmap);
-	painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-
-	QColor d{backgroundColor};
-	d.setAlpha(255);
-
-    // darken:
-    painter.fillRect(pixmap->rect(), d);
-	scopeDisplay->update();
-#endif
+	postToPlotter([this]{
+		plotter->wipe();
+	});
 }
 
 QAudioDevice ScopeWidget::getOutputDeviceInfo() const
@@ -393,7 +491,10 @@ void ScopeWidget::setPlotmode(Plotmode newPlotmode)
 	} else {
 		sweepParameters.sweepUnused = true;
 	}
-	plotter->setPlotMode(plotMode);
+	postToPlotter([this, m = plotMode]{
+		plotter->setPlotMode(m);
+	});
+	updateUpsampleFactor();
 }
 
 bool ScopeWidget::getUpsampling() const
@@ -401,14 +502,42 @@ bool ScopeWidget::getUpsampling() const
 	return upsampling;
 }
 
+int ScopeWidget::getUpsampleFactor() const
+{
+	return upsampleFactor;
+}
+
 void ScopeWidget::setUpsampling(bool val)
 {
 	upsampling = val;
-	sweepParameters.setUpsampleFactor(upsampling ? static_cast<double>(upsampleFactor) : 1.0);
-	plotter->setSweepParameters(sweepParameters);
-	if (upsampling) {
-		upsampler.reset();
+	updateUpsampleFactor();
+}
+
+void ScopeWidget::updateUpsampleFactor()
+{
+	// short sweeps of low sample-rate material need the most upsampling to get smooth traces;
+	// long sweeps (or high sample rates) need little or none
+	int factor = 1;
+	if (upsampling && fileLoaded) {
+		const int sampleRate = audioClock.getSampleRate();
+		factor = (plotMode == Sweep)
+				? UpsampleFactors::forSweep(sampleRate, sweepParameters.getSamplesPerSweep(), static_cast<int>(w))
+				: UpsampleFactors::forXY(sampleRate);
+	}
+
+	if (factor == upsampleFactor) {
+		return;
 	}
+
+	constexpr bool debugUpsampling = false;
+	if constexpr (debugUpsampling) {
+		qDebug() << "upsample factor:" << upsampleFactor << "->" << factor;
+	}
+
+	// (the decoder switches at its next block, and the plotter follows the factor recorded in each block)
+	upsampleFactor = factor;
+	sweepParameters.setUpsampleFactor(static_cast<double>(upsampleFactor));
+	decoder->setUpsampleFactor(upsampleFactor);
 }
 
 void ScopeWidget::setAudioVolume(qreal linearVolume)
@@ -416,6 +545,26 @@ void ScopeWidget::setAudioVolume(qreal linearVolume)
 	audioController->setOutputVolume(linearVolume);
 }
 
+int ScopeWidget::getAudioBufferDuration_ms() const
+{
+	return audioController->getBufferDuration_ms();
+}
+
+void ScopeWidget::setAudioBufferDuration_ms(int duration_ms)
+{
+	if (duration_ms == audioController->getBufferDuration_ms()) {
+		return;
+	}
+
+	audioController->setBufferDuration_ms(duration_ms);
+	if (fileLoaded) {
+		audioController->initializeAudio(audioFormat, outputDeviceInfo);
+		if (!paused) {
+			setPaused(false); // restart
+		}
+	}
+}
+
 void ScopeWidget::setSweepParameters(const SweepParameters &newSweepParameters)
 {
 	double newDuration = newSweepParameters.duration_ms;
@@ -430,17 +579,29 @@ void ScopeWidget::setSweepParameters(const SweepParameters &newSweepParameters)
 		sweepParameters.triggerTolerance = newTriggerTolerance;
 		sweepParameters.triggerMin  = newTriggerLevel - sweepParameters.triggerTolerance;
 		sweepParameters.triggerMax  = newTriggerLevel + sweepParameters.triggerTolerance;
-		if (paused) {
-			setShowTrigger(showTrigger);
-		}
 	}
 
 	sweepParameters.slope = newSweepParameters.slope;
 	sweepParameters.triggerEnabled = newSweepParameters.triggerEnabled;
+	sweepParameters.triggerMode = newSweepParameters.triggerMode;
+	sweepParameters.triggerSource = newSweepParameters.triggerSource;
+	sweepParameters.triggerHoldoff_ms = newSweepParameters.triggerHoldoff_ms;
+	sweepParameters.runtLevel = newSweepParameters.runtLevel;
+	sweepParameters.pulseWidthMin_ms = newSweepParameters.pulseWidthMin_ms;
+	sweepParameters.pulseWidthMax_ms = newSweepParameters.pulseWidthMax_ms;
+	sweepParameters.triggerPosition = newSweepParameters.triggerPosition;
+	sweepParameters.traces = newSweepParameters.traces;
+	sweepParameters.envelopeRms = newSweepParameters.envelopeRms;
 	sweepParameters.setWidthFrameRate(w, audioFramesPerMs);
-	if (plotter != nullptr) {
-		plotter->setSweepParameters(sweepParameters);
+	postToPlotter([this, p = sweepParameters]{
+		plotter->setSweepParameters(p);
+	});
+
+	// (redraw the trigger preview, after the plotter has the new parameters)
+	if (paused) {
+		updateTriggerOverlays();
 	}
+	updateUpsampleFactor();
 }
 
 bool ScopeWidget::getShowTrigger() const
@@ -448,42 +609,84 @@ bool ScopeWidget::getShowTrigger() const
 	return showTrigger;
 }
 
+bool ScopeWidget::getShowTriggerPosition() const
+{
+	return showTriggerPosition;
+}
+
 bool ScopeWidget::getconnectSamples() const
 {
-	return plotter != nullptr && plotter->getconnectSamples();
+	return connectSamples;
+}
+
+bool ScopeWidget::getVelocityModulation() const
+{
+	return velocityModulation;
 }
 
 void ScopeWidget::setShowTrigger(bool val)
 {
 	showTrigger = (plotMode == Sweep) && val;
-	if (paused) {
-#ifdef SNDSCOPE_BLEND2D
+	updateTriggerOverlays();
+}
 
-#else
-		auto pixmap = scopeDisplay->getPixmap();
-		QPainter painter(pixmap);
-		painter.beginNativePainting();
-		painter.setRenderHint(QPainter::Antialiasing, false);
-		painter.fillRect(pixmap->rect(), Qt::black);
+void ScopeWidget::setShowTriggerPosition(bool val)
+{
+	showTriggerPosition = (plotMode == Sweep) && val;
+	updateTriggerOverlays();
+}
 
-		if (showTrigger) {
-			plotter->drawTrigger(&painter);
-		}
-		painter.endNativePainting();
-		scopeDisplay->update();
-#endif
+void ScopeWidget::updateTriggerOverlays()
+{
+	if (paused) {
+		postToPlotter([this, t = showTrigger, p = showTriggerPosition]{
+			plotter->showTriggerPreview(t, p);
+		});
 	} else {
-		plotter->setShowTrigger(showTrigger);
+		postToPlotter([this, t = showTrigger, p = showTriggerPosition]{
+			plotter->setShowTrigger(t);
+			plotter->setShowTriggerPosition(p);
+		});
 	}
 }
 
 void ScopeWidget::setconnectSamples(bool val)
 {
-	if (plotter != nullptr) {
+	connectSamples = val;
+	postToPlotter([this, val]{
 		plotter->setconnectSamples(val);
-	}
+	});
 }
 
+void ScopeWidget::setVelocityModulation(bool val)
+{
+	velocityModulation = val;
+	postToPlotter([this, val]{
+		plotter->setVelocityModulation(val);
+	});
+}
+
+
+FrameStats ScopeWidget::getFrameStats() const
+{
+	return scopeDisplay->getSwapChain()->getStats();
+}
+
+int64_t ScopeWidget::getCoalescedJobs() const
+{
+	return coalescedJobs;
+}
+
+const SampleBlockPool *ScopeWidget::getSamplePool() const
+{
+	return &samplePool;
+}
+
+void ScopeWidget::waitForRenderThread()
+{
+	// since jobs and settings are queued in order, an empty blocking call returns once everything before it is done
+	QMetaObject::invokeMethod(plotter, []{}, Qt::BlockingQueuedConnection);
+}
 
 SweepParameters ScopeWidget::getSweepParameters() const
 {
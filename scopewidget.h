@@ -10,28 +10,27 @@
 #ifndef SCOPEWIDGET_H
 #define SCOPEWIDGET_H
 
+#include "audioclock.h"
 #include "audiocontroller.h"
+#include "audioring.h"
+#include "audioringdevice.h"
+#include "decoder.h"
+#include "frameswapchain.h"
+#include "phosphor.h"
 #include "plotmode.h"
 #include "plotter.h"
 #include "sweepparameters.h"
-#include "upsampler.h"
 
 #include <sndfile.hh>
 
-#ifdef SNDSCOPE_BLEND2D
-	#include "blimagewrapper.h"
-#endif
-
 #include <QAudioDevice>
 #include <QColor>
 #include <QDebug>
-#include <QElapsedTimer>
 #include <QHBoxLayout>
+#include <QImage>
 #include <QLabel>
 #include <QMediaDevices>
 #include <QPainter>
-#include <QPixmap>
-#include <QPixmap>
 #include <QResizeEvent>
 #include <QThread>
 #include <QTime>
@@ -41,59 +40,46 @@
 #include <memory>
 
 // ScopeDisplay : this is the Oscilloscope's screen
-// it owns a QPixmap as an image buffer, which is accessed via getPixmap()
+// it owns a FrameSwapChain, into which the Plotter renders (see getSwapChain()),
+// and presents whichever frame was most recently completed
 
 class ScopeDisplay : public QWidget
 {
 	Q_OBJECT
 public:
 
-#ifdef SNDSCOPE_BLEND2D
-	ScopeDisplay(QWidget* parent = nullptr) : QWidget(parent), pixmap(800, 640), blImageWrapper(std::make_unique<BLImageWrapper>(800, 640))
-#else
-	ScopeDisplay(QWidget* parent = nullptr) : QWidget(parent), pixmap(800, 640)
-#endif
-
+	ScopeDisplay(QWidget* parent = nullptr) : QWidget(parent)
     {
+		swapChain.resize({800, 640}, Qt::black);
         setAutoFillBackground(false);
         resizeCooldownTimer.setSingleShot(true);
         resizeCooldownTimer.setInterval(50);
         setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
 
-        // actual resizing of pixmap is only done after waiting for resize events to settle-down
+        // actual resizing of the swap chain is only done after waiting for resize events to settle-down
 		connect(&resizeCooldownTimer, &QTimer::timeout, this, [this]{
-            if (pixmap.height() != height()) {
+            if (swapChain.size().height() != height()) {
                 const int h = height();
 				const int w = aspectRatio.first * h / aspectRatio.second;
-                qDebug().noquote() << QStringLiteral("adjusting pixmap resolution to %1x%2").arg(w).arg(h);
-				#ifdef SNDSCOPE_BLEND2D
-				blImageWrapper = std::make_unique<BLImageWrapper>(w, h);
-#else
-                pixmap = pixmap.scaled(w, h);
-#endif
+                qDebug().noquote() << QStringLiteral("adjusting render resolution to %1x%2").arg(w).arg(h);
+				emit resolutionAboutToChange();
+				swapChain.resize({w, h}, Qt::black);
+				scaledFrameNumber = -1ll;
 				calcGraticule();
-                emit pixmapResolutionChanged(pixmap.size());
+                emit resolutionChanged(swapChain.size());
             }
         });
 	}
 
 	// getters 
-#ifdef SNDSCOPE_BLEND2D
-	BLImageWrapper*getBlImageWrapper() const
+	FrameSwapChain* getSwapChain()
 	{
-		return blImageWrapper.get();
+		return &swapChain;
 	}
 
-#else
-	QPixmap* getPixmap()
-    {
-        return &pixmap;
-    }
-#endif
-
-    bool getAllowPixmapResolutionChange() const
+    bool getAllowResolutionChange() const
     {
-        return allowPixmapResolutionChange;
+        return allowResolutionChange;
     }
 
 	QPair<int, int> getAspectRatio() const
@@ -108,9 +94,9 @@ public:
 
 	// setters
 
-    void setAllowPixmapResolutionChange(bool value)
+    void setAllowResolutionChange(bool value)
     {
-        allowPixmapResolutionChange = value;
+        allowResolutionChange = value;
     }
 
 	void setAspectRatio(const QPair<int, int> &newAspectRatio)
@@ -135,12 +121,13 @@ public:
 
 
 signals:
-	void pixmapResolutionChanged(const QSizeF& size);
+	void resolutionAboutToChange();
+	void resolutionChanged(const QSizeF& size);
 
 protected:
     QSize sizeHint() const override
     {
-        return pixmap.size();
+        return swapChain.size();
     }
 
     void paintEvent(QPaintEvent *event) override
@@ -149,21 +136,30 @@ protected:
 		QPainter p(this);
 		p.setRenderHint(QPainter::TextAntialiasing, false);
 
-#ifdef SNDSCOPE_BLEND2D
-		p.drawImage(0, 0, *blImageWrapper->getQImage());
-#else
-        if (size() == pixmap.size()) {
-            p.drawPixmap(0, 0, pixmap);
-        } else {
-            p.drawPixmap(0, 0, pixmap.scaled(size()));
-        }
-#endif
+		// take the most recently completed frame (if any), otherwise re-present the current one
+		const QImage *frame = swapChain.acquire();
+		if (size() == frame->size()) {
+			p.drawImage(0, 0, *frame);
+		} else {
+			// until the swap chain catches up with a resize, frames are stretched to fit, into an image that is
+			// kept for re-use : each frame is only scaled once, however many times it gets painted
+			const int64_t frameNumber = swapChain.getStats().presented;
+			if (scaledFrame.size() != size()) {
+				scaledFrame = QImage(size(), QImage::Format_ARGB32_Premultiplied);
+				scaledFrameNumber = -1ll;
+			}
+			if (frameNumber != scaledFrameNumber) {
+				QPainter sp(&scaledFrame);
+				sp.setCompositionMode(QPainter::CompositionMode_Source);
+				sp.drawImage(scaledFrame.rect(), *frame);
+				sp.end();
+				scaledFrameNumber = frameNumber;
+			}
+			p.drawImage(0, 0, scaledFrame);
+		}
 
 		if (showGraticule) {
-			p.setRenderHint(QPainter::Antialiasing, true);
-			QPen graticulePen(graticuleColor, 1.5);
-			p.setPen(graticulePen);
-			p.drawLines(graticuleLines);
+			p.drawImage(QRectF{QPointF{0.0, 0.0}, graticuleImage.deviceIndependentSize()}, graticuleImage);
 		}
     }
 
@@ -176,7 +172,7 @@ protected:
 		setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
 		updateGeometry();
 
-		if (allowPixmapResolutionChange) {
+		if (allowResolutionChange) {
 			resizeCooldownTimer.start();
 		}
 
@@ -230,6 +226,23 @@ protected:
 			}
 			gy += divy;
 		}
+
+		renderGraticule();
+	}
+
+	// the graticule only changes when the widget is resized : draw it once, into a transparent overlay
+	void renderGraticule()
+	{
+		const qreal dpr = devicePixelRatioF();
+		graticuleImage = QImage(size() * dpr, QImage::Format_ARGB32_Premultiplied);
+		graticuleImage.setDevicePixelRatio(dpr);
+		graticuleImage.fill(Qt::transparent);
+
+		QPainter p(&graticuleImage);
+		p.setRenderHint(QPainter::Antialiasing, true);
+		p.setPen(QPen{graticuleColor, 1.5});
+		p.drawLines(graticuleLines);
+		p.end();
 	}
 
 private:
@@ -238,15 +251,16 @@ private:
 	QPair<int, int> aspectRatio{5, 4};
 	QTimer resizeCooldownTimer;
 
-    QPixmap pixmap;
-
-#ifdef SNDSCOPE_BLEND2D
-	std::unique_ptr<BLImageWrapper> blImageWrapper;
-#endif
+	FrameSwapChain swapChain;
 
-	bool allowPixmapResolutionChange{true};
+	bool allowResolutionChange{true};
 	QVector<QPointF> graticuleLines;
+	QImage graticuleImage;
 	bool showGraticule{true};
+
+	// stretched copy of the presented frame (while the swap chain's size differs from the widget's)
+	QImage scaledFrame;
+	int64_t scaledFrameNumber{-1ll}; // (FrameStats::presented count when scaledFrame was made)
 };
 
 // ScopeWidget : the heart of the Oscilloscope
@@ -255,9 +269,20 @@ class ScopeWidget : public QWidget
 {
 	Q_OBJECT
 	friend class Plotter;
-	static constexpr int upsampleFactor = 4;
+	static constexpr int audioRingDuration_ms = 250; // max amount of audio the decoder may queue up for output
+	static constexpr size_t pendingCapacity = 64; // max number of decoded blocks waiting to become audible (must cover audioRingDuration_ms)
+	static constexpr int metricsInterval = 50; // number of plotTimer timeouts between clockMetrics() reports
+
+	// PendingBlock : samples which have been queued for audio output, but not yet heard
+	struct PendingBlock
+	{
+		int64_t endFrame{0ll}; // position (in file) one past last frame
+		int64_t endPosition{0ll}; // position (in AudioRing) one past last frame
+		SampleBlockPtr samples;
+	};
 
 	QThread renderThread;
+	QThread decodeThread;
 
 public:
 	explicit ScopeWidget(QWidget *parent = nullptr);
@@ -273,35 +298,46 @@ public:
 	double getBrightness() const;
 	double getFocus() const;
 	QColor getPhosphorColor() const;
+	Phosphor getPhosphor() const;
 	double getPersistence() const;
 	bool getMultiColor() const;
 	QColor getBackgroundColor() const;
 	SweepParameters getSweepParameters() const;
 	QAudioDevice getOutputDeviceInfo() const;
 	bool getShowTrigger() const;
+	bool getShowTriggerPosition() const;
 	bool getconnectSamples() const;
+	bool getVelocityModulation() const;
+	int getAudioBufferDuration_ms() const;
+	const SampleBlockPool *getSamplePool() const;
+	FrameStats getFrameStats() const;
+	int64_t getCoalescedJobs() const; // (times the renderer was too busy to take a job, so it was merged with the next)
 
 	// setters
 	void setPaused(bool value);
 	void setBrightness(double value);
 	void setFocus(double value);
 	void setPersistence(double time_ms);
-	void setPhosporColors(const QVector<QColor> &colors);
+	void setPhosphor(const Phosphor &newPhosphor);
 	void setBackgroundColor(const QColor &value);
 	void setOutputDevice(const QAudioDevice &newOutputDeviceInfo);
 	void setShowTrigger(bool val);
+	void setShowTriggerPosition(bool val);
 	void setconnectSamples(bool val);
+	void setVelocityModulation(bool val);
 
 	void plotTest();
 
 
 	bool getUpsampling() const;
+	int getUpsampleFactor() const;
 
 public slots:
 	void returnToStart();
 	void gotoPosition(int64_t milliSeconds);
 	void wipeScreen();
 	void setAudioVolume(qreal linearVolume);
+	void setAudioBufferDuration_ms(int duration_ms);
 	void setSweepParameters(const SweepParameters &newSweepParameters);
 	void setPlotmode(Plotmode newPlotmode);
 	void setUpsampling(bool val);
@@ -309,6 +345,7 @@ public slots:
 signals:
 	void loadedFile();
 	void renderedFrame(int positionMilliseconds);
+	void clockMetrics(double avOffset_ms, double drift_ppm);
 	void outputVolume(qreal linearVol);
 
 protected:
@@ -317,38 +354,42 @@ private:
     ScopeDisplay* scopeDisplay{nullptr};
 	AudioController *audioController{nullptr};
 	Plotter *plotter{nullptr};
-	QIODevice* pushOut{nullptr};
+	Decoder *decoder{nullptr};
+	AudioRingDevice *audioRingDevice{nullptr};
 	QHBoxLayout *screenLayout{nullptr};
 	std::unique_ptr<SndfileHandle> sndfile;
 	QAudioFormat audioFormat;
 	QAudioDevice outputDeviceInfo;
-	UpSampler<float, float, upsampleFactor> upsampler;
 
 	// audio buffers
-	QVector<float> rawinputBuffer; // interleaved
-	QVector<QVector<float>> inputBuffers; // de-interleaved
+	AudioRing audioRing; // interleaved, waiting to be pulled by the sound card
+	SampleBlockPool samplePool; // de-interleaved sample storage; shared by decoder and plotter
+	SpscRing<PendingBlock, pendingCapacity> pendingBlocks; // de-interleaved, waiting to become audible
+	RenderJob renderJob; // de-interleaved, waiting to be submitted to plotter
+	int64_t coalescedJobs{0ll}; // number of times the renderer was too busy to accept a job
 
 	// timing
 	QTimer plotTimer;
     QTimer screenUpdateTimer;
-	QElapsedTimer elapsedTimer;
+	AudioClock audioClock;
+	int metricsCountdown{0};
 
 	Plotmode plotMode{XY};
 	bool showTrigger{false};
+	bool showTriggerPosition{false};
 	SweepParameters sweepParameters;
 
 	bool upsampling{false};
+	int upsampleFactor{1}; // factor currently in use (chosen to suit sample rate and sweep)
 	int numInputChannels{0};
-	int audioFramesPerMs{0};
+	double audioFramesPerMs{0.0};
 	double msPerAudioFrame{0.0};
 
 	// audio frame accounting
-	int64_t startFrame{0ll}; // start position for playback
-	int64_t currentFrame{0ll}; // start position of next read
-	int64_t framesRead{0ll}; // number of audioframes last read from file
-	int64_t framesAvailable{011}; // number of audioframes currently stored in input buffers; after upsampling
+	int64_t currentFrame{0ll}; // position (one past last frame) handed to renderer
+	int64_t currentPosition{0ll}; // position in audioRing corresponding to currentFrame
+	int64_t framesRead{0ll}; // number of audioframes last handed to renderer
 	int64_t expectedFrames{0ll}; // number of audioframes expected per plotTimer timeout
-	int64_t maxFramesToRead{0ll}; // limit of how many audioframes can fit in buffer
 	int64_t totalFrames{0ll}; // total number of audioframes in sound file
 
 	bool fileLoaded{false};
@@ -360,7 +401,14 @@ private:
 	qreal persistence{32.0};
 
 	QColor backgroundColor{0, 0, 0, 255};
-	int beamAlpha; // todo: try AlphaF (qreal)
+
+	// copies of plotter settings (the plotter itself lives on the render thread)
+	Phosphor phosphor{QStringLiteral("P31"), {{QColor{0x3e, 0xff, 0x6f, 0xff}, 32.0}}};
+	QColor phosphorColor{0x3e, 0xff, 0x6f, 0xff};
+	qreal beamWidth{1.0};
+	qreal beamEnergy{0.0};
+	bool connectSamples{false};
+	bool velocityModulation{true};
 
 	// plot dimensions
 	qreal cx;
@@ -370,7 +418,21 @@ private:
 
 	// private functions
 	void readInput();
-	void calcBeamAlpha();
+	void seek(int64_t frame);
+	void clearPendingBlocks();
+	void updateUpsampleFactor();
+	void updateTriggerOverlays();
+	void updatePhosphorLayers();
+	void waitForRenderThread();
+
+	// run f on the render thread, in order with render jobs
+	template<typename F>
+	void postToPlotter(F &&f)
+	{
+		QMetaObject::invokeMethod(plotter, std::forward<F>(f), Qt::QueuedConnection);
+	}
+
+	void calcBeamEnergy();
 	void drawTrigger(QPainter *painter);
 	void makeTestPlot();
 };
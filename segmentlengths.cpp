@@ -0,0 +1,112 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "segmentlengths.h"
+
+#include "cpufeatures.h"
+
+#include <cmath>
+
+#ifdef SNDSCOPE_SSE2
+#include <immintrin.h>
+#endif
+
+// QPointF is read directly as interleaved coordinates : x0, y0, x1, y1, ...
+static_assert(sizeof(QPointF) == 2 * sizeof(qreal) && sizeof(qreal) == sizeof(double));
+
+using MeasureFunction = void (*)(const double *coords, qsizetype numSegments, float *lengths);
+
+static void measureScalar(const double *coords, qsizetype numSegments, float *lengths)
+{
+	for (qsizetype i = 0; i < numSegments; i++) {
+		const double *s = coords + 4 * i;
+		const double dx = s[2] - s[0];
+		const double dy = s[3] - s[1];
+		lengths[i] = static_cast<float>(std::sqrt(dx * dx + dy * dy));
+	}
+}
+
+#ifdef SNDSCOPE_SSE2
+
+static void measureSSE2(const double *coords, qsizetype numSegments, float *lengths)
+{
+	// one segment per vector : (dx, dy) = end - start
+	auto squares = [coords](qsizetype i) {
+		const __m128d d = _mm_sub_pd(_mm_loadu_pd(coords + 4 * i + 2), _mm_loadu_pd(coords + 4 * i));
+		return _mm_mul_pd(d, d);
+	};
+
+	// length of two segments : transpose to (dx0^2, dx1^2) + (dy0^2, dy1^2)
+	auto lengths2 = [&squares](qsizetype i) {
+		const __m128d s0 = squares(i);
+		const __m128d s1 = squares(i + 1);
+		return _mm_cvtpd_ps(_mm_sqrt_pd(_mm_add_pd(_mm_unpacklo_pd(s0, s1), _mm_unpackhi_pd(s0, s1))));
+	};
+
+	qsizetype i = 0;
+	for (; i + 4 <= numSegments; i += 4) {
+		_mm_storeu_ps(lengths + i, _mm_movelh_ps(lengths2(i), lengths2(i + 2)));
+	}
+	measureScalar(coords + 4 * i, numSegments - i, lengths + i);
+}
+
+#endif // SNDSCOPE_SSE2
+
+#ifdef SNDSCOPE_AVX2
+
+SNDSCOPE_TARGET("avx2")
+static void measureAVX2(const double *coords, qsizetype numSegments, float *lengths)
+{
+	qsizetype i = 0;
+	for (; i + 4 <= numSegments; i += 4) {
+		const double *s = coords + 4 * i;
+		const __m256d v0 = _mm256_loadu_pd(s);
+		const __m256d v1 = _mm256_loadu_pd(s + 4);
+		const __m256d v2 = _mm256_loadu_pd(s + 8);
+		const __m256d v3 = _mm256_loadu_pd(s + 12);
+
+		// (dx0, dy0, dx1, dy1) = (end0, end1) - (start0, start1)
+		const __m256d d01 = _mm256_sub_pd(_mm256_permute2f128_pd(v0, v1, 0x31), _mm256_permute2f128_pd(v0, v1, 0x20));
+		const __m256d d23 = _mm256_sub_pd(_mm256_permute2f128_pd(v2, v3, 0x31), _mm256_permute2f128_pd(v2, v3, 0x20));
+
+		// horizontal add gives squared lengths in the order 0, 2, 1, 3
+		const __m256d sq = _mm256_hadd_pd(_mm256_mul_pd(d01, d01), _mm256_mul_pd(d23, d23));
+		const __m128 l = _mm256_cvtpd_ps(_mm256_sqrt_pd(sq));
+		_mm_storeu_ps(lengths + i, _mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+	measureScalar(coords + 4 * i, numSegments - i, lengths + i);
+}
+
+#endif // SNDSCOPE_AVX2
+
+struct MeasureImplementation
+{
+	MeasureFunction function;
+	const char *name;
+};
+
+static const MeasureImplementation &getImplementation()
+{
+	// (see CpuFeatures::select())
+	static const MeasureImplementation implementation = CpuFeatures::select<MeasureImplementation>(
+		{measureScalar, "scalar"},
+		SNDSCOPE_SSE2_IMPLEMENTATION(MeasureImplementation{measureSSE2, "SSE2"}),
+		SNDSCOPE_AVX2_IMPLEMENTATION(MeasureImplementation{measureAVX2, "AVX2"}));
+	return implementation;
+}
+
+void SegmentLengths::measure(const QPointF *points, qsizetype numSegments, float *lengths)
+{
+	getImplementation().function(reinterpret_cast<const double *>(points), numSegments, lengths);
+}
+
+const char *SegmentLengths::implementation()
+{
+	return getImplementation().name;
+}
@@ -0,0 +1,26 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef SEGMENTLENGTHS_H
+#define SEGMENTLENGTHS_H
+
+#include <QPointF>
+
+// SegmentLengths : lengths of a batch of line segments, given as pairs of points (start, end),
+// as used for beam-velocity modulation (the beam spends the same time on every segment,
+// so its energy per unit length is inversely proportional to the segment's length).
+// The best implementation for the CPU is selected at run-time
+
+struct SegmentLengths
+{
+	static void measure(const QPointF *points, qsizetype numSegments, float *lengths);
+	static const char *implementation();
+};
+
+#endif // SEGMENTLENGTHS_H
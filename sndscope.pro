@@ -9,8 +9,7 @@ QT += core gui multimedia widgets
 
 CONFIG += c++17
 
-#activate blend2d to do the rendering (instead of QPainter):
-#CONFIG += blend2d
+#the plot kernel microbenchmark is a separate project : bench/plotterbench.pro
 
 AVX2 {
  message(Enabling AVX2)
@@ -37,20 +36,6 @@ win32 {
     LIBS += -L$${LIBSNDFILEPATH}/lib -lsndfile
     INCLUDEPATH += $${LIBSNDFILEPATH}/include
 
-    blend2d {
-        # path to blend2d headers
-        BLEND2DINCLUDE = $$clean_path($$PWD/../blend2d/src)
-
-        # path to blend2d library files
-        BLEND2DLIB = $$clean_path($$PWD/../blend2dlib)
-
-        message(blend2d include path: $$BLEND2DINCLUDE)
-        message(blend2d library path: $$BLEND2DLIB)
-
-        LIBS += -L$${BLEND2DLIB} -lblend2d
-        INCLUDEPATH += $${BLEND2DINCLUDE}
-    }
-
     #copy libsndfile dll to build folder
     CONFIG += file_copies
     COPIES += dlls
@@ -59,44 +44,72 @@ win32 {
 }
 
 SOURCES += \
+    audioclock.cpp \
     audiocontroller.cpp \
+    audioring.cpp \
+    audioringdevice.cpp \
     audiosettingswidget.cpp \
+    beamkernel.cpp \
+    beamrasteriser.cpp \
+    cpufeatures.cpp \
+    decoder.cpp \
+    deinterleave.cpp \
     displaysettingswidget.cpp \
+    frameswapchain.cpp \
+    intensitydecay.cpp \
     main.cpp \
     mainwindow.cpp \
     phosphor.cpp \
     plotmode.cpp \
     plotmodewidget.cpp \
     plotter.cpp \
+    polyphase.cpp \
+    sampleblock.cpp \
+    samplehistory.cpp \
     scopewidget.cpp \
+    segmentlengths.cpp \
     sweepsettingswidget.cpp \
-    transportwidget.cpp
+    transportwidget.cpp \
+    triggerengine.cpp \
+    triggermode.cpp \
+    upsampler.cpp \
+    workerpool.cpp
 
 HEADERS += \
+    audioclock.h \
     audiocontroller.h \
+    audioring.h \
+    audioringdevice.h \
     audiosettingswidget.h \
-    blimagewrapper.h \
-    delayline.h \
-    differentiator.h \
+    beamkernel.h \
+    beamrasteriser.h \
+    cpufeatures.h \
+    decoder.h \
+    deinterleave.h \
     displaysettingswidget.h \
+    filterdesign.h \
+    frameswapchain.h \
     functimer.h \
+    intensitydecay.h \
     mainwindow.h \
     movingaverage.h \
     phosphor.h \
     plotmode.h \
     plotmodewidget.h \
     plotter.h \
+    polyphase.h \
+    sampleblock.h \
+    samplehistory.h \
     scopewidget.h \
+    segmentlengths.h \
+    spscring.h \
     sweepparameters.h \
     sweepsettingswidget.h \
     transportwidget.h \
-    upsampler.h
-
-blend2d {
-    SOURCES +=  blimagewrapper.cpp
-    HEADERS +=  blimagewrapper.h
-    DEFINES += SNDSCOPE_BLEND2D
-}
+    triggerengine.h \
+    triggermode.h \
+    upsampler.h \
+    workerpool.h
 
 TRANSLATIONS += \
     sndscope_en_AU.ts
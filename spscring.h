@@ -0,0 +1,90 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// SpscRing : fixed-capacity, lock-free, single-producer / single-consumer ring of slots.
+// Slots are pre-allocated and filled / consumed in-place:
+// the producer calls writeSlot() ... commitWrite(), and the consumer calls readSlot() ... commitRead().
+// Exactly one thread may act as producer, and exactly one thread may act as consumer.
+
+template<typename T, size_t Capacity>
+class SpscRing
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of 2");
+	static constexpr size_t mask{Capacity - 1};
+
+	std::array<T, Capacity> slots;
+	alignas(64) std::atomic<size_t> head{0}; // index of next slot to read (advanced by consumer)
+	alignas(64) std::atomic<size_t> tail{0}; // index of next slot to write (advanced by producer)
+
+public:
+	static constexpr size_t capacity()
+	{
+		return Capacity;
+	}
+
+	// producer: returns slot to be written, or nullptr if ring is full
+	T* writeSlot()
+	{
+		const size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == Capacity) {
+			return nullptr;
+		}
+		return &slots[t & mask];
+	}
+
+	// producer: publish the slot returned by writeSlot()
+	void commitWrite()
+	{
+		tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// consumer: returns oldest unread slot, or nullptr if ring is empty
+	T* readSlot()
+	{
+		const size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		return &slots[h & mask];
+	}
+
+	// consumer: release the slot returned by readSlot() back to the producer
+	void commitRead()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// approximate number of slots in use (exact if called from either end)
+	size_t size() const
+	{
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+
+	// direct slot access for set-up (eg pre-allocating slot contents).
+	// Only call reset() / slot() when neither producer nor consumer is active.
+	T& slot(size_t i)
+	{
+		return slots[i & mask];
+	}
+
+	void reset()
+	{
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+	}
+};
+
+#endif // SPSCRING_H
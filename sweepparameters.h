@@ -1,9 +1,29 @@
 #ifndef SWEEPPARAMETERS_H
 #define SWEEPPARAMETERS_H
 
+#include "triggermode.h"
+
+#include <QColor>
 #include <QDebug>
+#include <QVector>
 #include <cmath>
 
+// per-channel trace settings (Sweep mode)
+struct TraceParameters
+{
+	bool visible{true};
+	double offset{0.0}; // (where the trace's zero sits, in full-scale units : +1 is the top of the screen)
+	double scale{1.0};
+	QColor color; // (invalid : the phosphor's own colour)
+
+	static QColor defaultColor(int ch)
+	{
+		// ch0 keeps the phosphor colour; the others get scope-style trace colours
+		static const QVector<QColor> colors{QColor{0x40, 0xe0, 0xff}, QColor{0xff, 0x60, 0xe0}, QColor{0xff, 0xe0, 0x40}};
+		return (ch == 0) ? QColor{} : colors.at((ch - 1) % colors.size());
+	}
+};
+
 struct SweepParameters
 {
 	friend class ScopeWidget;
@@ -14,10 +34,31 @@ struct SweepParameters
 	double slope{1.0};
 	bool sweepUnused{false};
 	bool triggerEnabled{true};
+	TriggerMode triggerMode{WindowTrigger};
+	int triggerSource{0}; // channel, or TriggerSourceMid / TriggerSourceSide
+	double triggerHoldoff_ms{0.0}; // (after each sweep, triggers are ignored for this long)
+	double runtLevel{0.5};
+	double pulseWidthMin_ms{0.0};
+	double pulseWidthMax_ms{0.0}; // (0 : no maximum)
+	double triggerPosition{0.0}; // (fraction of the sweep shown before the trigger; negative : delayed sweep)
+	bool envelopeRms{false}; // (long sweeps : brighten +/- 1 standard deviation within the min / max envelope)
 	int horizontalDivisions;
 	int verticalDivisions;
+	int inputChannels{2};
+	QVector<TraceParameters> traces; // (per channel; channels without an entry get the defaults)
 
 public:
+	TraceParameters getTrace(int ch) const
+	{
+		if (ch >= 0 && ch < traces.size()) {
+			return traces.at(ch);
+		}
+
+		TraceParameters t;
+		t.color = TraceParameters::defaultColor(ch);
+		return t;
+	}
+
 	double getDuration_ms() const
 	{
 		return duration_ms;
@@ -45,6 +86,12 @@ public:
 		return duration_ms * inputFrames_per_ms;
 	}
 
+	// number of (upsampled) frames in a given time
+	int64_t framesFor_ms(double t_ms) const
+	{
+		return std::llround(t_ms * inputFrames_per_ms * upsampleFactor);
+	}
+
 	double getUpsampleFactor() const;
 
 	static QString formatMeasurementUnits(double duration_s, const QString& units, int precision = 2)
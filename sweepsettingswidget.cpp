@@ -1,7 +1,8 @@
 #include "sweepsettingswidget.h"
 
 #include <QDebug>
-#include <QGroupBox>
+#include <QFormLayout>
+#include <QGridLayout>
 #include <QHBoxLayout>
 #include <QTimer>
 #include <QVBoxLayout>
@@ -18,12 +19,23 @@ SweepSettingsWidget::SweepSettingsWidget(QWidget *parent)
 	sweepDial->setOrientation(Qt::Orientation::Horizontal);
 	sweepInfo = new QLabel;
 
+	triggerPositionLabel = new QLabel("Position: 0%");
+	triggerPosition = new QSlider;
+	triggerPosition->setToolTip("Where the trigger appears on screen (negative : after the left edge, ie a delayed sweep)");
+	triggerPosition->setOrientation(Qt::Orientation::Horizontal);
+	triggerPosition->setRange(-100, 100);
+	triggerPosition->setTickInterval(10);
+	triggerPosition->setValue(0);
+
+	envelopeRms = new QCheckBox("Envelope RMS");
+	envelopeRms->setToolTip("When sweeps are too long to draw every sample, show the RMS (as a brighter core) within the min / max envelope");
+
 	auto triggerLevelLabel = new QLabel("Level");
 	triggerLevel = new QSlider;
 	triggerLevel->setRange(-32768, 32767);
 	triggerLevel->setValue(0);
 
-	auto triggerToleranceLabel = new QLabel("Tolerance");
+	triggerToleranceLabel = new QLabel("Tolerance");
 	triggerTolerance = new QSlider;
 	triggerTolerance->setRange(1, 100);
 	triggerTolerance->setValue(10);
@@ -32,7 +44,39 @@ SweepSettingsWidget::SweepSettingsWidget(QWidget *parent)
 	triggerEnabled->setChecked(true);
 	triggerResetButton = new QCheckBox("Reset");
 
+	triggerModeSelector = new QComboBox;
+	for (const TriggerModeDefinition &t : TriggerModeManager::getTriggerModeMap()) {
+		triggerModeSelector->addItem(t.name, t.triggerMode);
+		triggerModeSelector->setItemData(triggerModeSelector->count() - 1, t.description, Qt::ToolTipRole);
+	}
 
+	triggerSourceSelector = new QComboBox;
+	populateTriggerSources();
+
+	triggerHoldoff = new QDoubleSpinBox;
+	triggerHoldoff->setToolTip("Minimum time from the end of a sweep to the next trigger");
+	triggerHoldoff->setRange(0.0, 10000.0);
+	triggerHoldoff->setDecimals(2);
+	triggerHoldoff->setSuffix(" ms");
+
+	pulseWidthMin = new QDoubleSpinBox;
+	pulseWidthMin->setRange(0.0, 10000.0);
+	pulseWidthMin->setDecimals(3);
+	pulseWidthMin->setSingleStep(0.1);
+	pulseWidthMin->setSuffix(" ms");
+
+	pulseWidthMax = new QDoubleSpinBox;
+	pulseWidthMax->setToolTip("0 : no maximum");
+	pulseWidthMax->setRange(0.0, 10000.0);
+	pulseWidthMax->setDecimals(3);
+	pulseWidthMax->setSingleStep(0.1);
+	pulseWidthMax->setSuffix(" ms");
+
+	runtLevel = new QSlider;
+	runtLevel->setToolTip("Pulses which fail to reach this level are runts");
+	runtLevel->setOrientation(Qt::Orientation::Horizontal);
+	runtLevel->setRange(-32768, 32767);
+	runtLevel->setValue(16384);
 
 	auto slopeDialLabel = new QLabel("Slope: /");
 	slopeDial = new QDial;
@@ -61,6 +105,9 @@ SweepSettingsWidget::SweepSettingsWidget(QWidget *parent)
 
 	sweepLayout->addLayout(sweepSpeedLayout);
 	sweepLayout->addLayout(sweepInfoLayout);
+	sweepLayout->addWidget(triggerPositionLabel);
+	sweepLayout->addWidget(triggerPosition);
+	sweepLayout->addWidget(envelopeRms);
 
 	triggerLevelLayout->addWidget(triggerLevelLabel);
 	triggerLevelLayout->addWidget(triggerLevel);
@@ -82,14 +129,30 @@ SweepSettingsWidget::SweepSettingsWidget(QWidget *parent)
 	triggerLayout->addLayout(triggerToleranceLayout, 2);
 	triggerLayout->addLayout(triggerSlopeLayout,2);
 
+	auto triggerModeLayout = new QFormLayout;
+	triggerModeLayout->addRow("Mode", triggerModeSelector);
+	triggerModeLayout->addRow("Source", triggerSourceSelector);
+	triggerModeLayout->addRow("Holdoff", triggerHoldoff);
+	triggerModeLayout->addRow("Min Width", pulseWidthMin);
+	triggerModeLayout->addRow("Max Width", pulseWidthMax);
+	triggerModeLayout->addRow("Runt Level", runtLevel);
+
+	auto triggerBoxLayout = new QVBoxLayout;
+	triggerBoxLayout->addLayout(triggerLayout);
+	triggerBoxLayout->addLayout(triggerModeLayout);
+
 	auto sweepBox = new QGroupBox("Sweep");
 	auto triggerBox = new QGroupBox("Trigger");
 
 	sweepBox->setLayout(sweepLayout);
-	triggerBox->setLayout(triggerLayout);
+	triggerBox->setLayout(triggerBoxLayout);
+
+	tracesBox = new QGroupBox("Traces");
+	tracesBox->setLayout(new QVBoxLayout);
 
 	mainLayout->addWidget(sweepBox);
 	mainLayout->addWidget(triggerBox);
+	mainLayout->addWidget(tracesBox);
 
 	setLayout(mainLayout);
 
@@ -101,6 +164,25 @@ SweepSettingsWidget::SweepSettingsWidget(QWidget *parent)
 		emit sweepParametersChanged(sweepParameters);
 	});
 
+	connect(triggerPosition, &QSlider::valueChanged, this, [this](int value){
+		sweepParameters.triggerPosition = 0.01 * value;
+		triggerPositionLabel->setText(QStringLiteral("Position: %1%").arg(value));
+		emit sweepParametersChanged(sweepParameters);
+	});
+
+	connect(triggerPosition, &QSlider::sliderPressed, this, [this]{
+		emit triggerPositionPressed(true);
+	});
+
+	connect(triggerPosition, &QSlider::sliderReleased, this, [this]{
+		emit triggerPositionPressed(false);
+	});
+
+	connect(envelopeRms, &QCheckBox::toggled, this, [this](bool checked){
+		sweepParameters.envelopeRms = checked;
+		emit sweepParametersChanged(sweepParameters);
+	});
+
 	auto setSlopeLabel = [slopeDialLabel](int s) {
 		if (s < 0) {
 			slopeDialLabel->setText("Slope: \\");
@@ -110,22 +192,62 @@ SweepSettingsWidget::SweepSettingsWidget(QWidget *parent)
 	};
 
 	connect(triggerEnabled, &QCheckBox::checkStateChanged, this, [this](Qt::CheckState state){
-		triggerResetButton->setEnabled(state == Qt::Checked);
-		triggerLevel->setEnabled(state == Qt::Checked);
-		triggerTolerance->setEnabled(state == Qt::Checked);
-		slopeDial->setEnabled(state == Qt::Checked);
 		sweepParameters.triggerEnabled = (state == Qt::Checked);
+		updateTriggerControls();
+		emit sweepParametersChanged(sweepParameters);
+	});
+
+	connect(triggerModeSelector, QOverload<int>::of(&QComboBox::activated), this, [this]{
+		sweepParameters.triggerMode = triggerModeSelector->currentData().value<TriggerMode>();
+		updateTriggerControls();
+		emit sweepParametersChanged(sweepParameters);
+	});
+
+	connect(triggerSourceSelector, QOverload<int>::of(&QComboBox::activated), this, [this]{
+		sweepParameters.triggerSource = triggerSourceSelector->currentData().toInt();
+		emit sweepParametersChanged(sweepParameters);
+	});
+
+	connect(triggerHoldoff, &QDoubleSpinBox::valueChanged, this, [this](double value){
+		sweepParameters.triggerHoldoff_ms = value;
+		emit sweepParametersChanged(sweepParameters);
+	});
+
+	connect(pulseWidthMin, &QDoubleSpinBox::valueChanged, this, [this](double value){
+		sweepParameters.pulseWidthMin_ms = value;
 		emit sweepParametersChanged(sweepParameters);
 	});
 
+	connect(pulseWidthMax, &QDoubleSpinBox::valueChanged, this, [this](double value){
+		sweepParameters.pulseWidthMax_ms = value;
+		emit sweepParametersChanged(sweepParameters);
+	});
+
+	connect(runtLevel, &QSlider::valueChanged, this, [this](int value){
+		sweepParameters.runtLevel = value / (-1.0 * runtLevel->minimum());
+		emit sweepParametersChanged(sweepParameters);
+	});
+
+	connect(runtLevel, &QSlider::sliderPressed, this, [this]{
+		emit triggerLevelPressed(true);
+	});
+
+	connect(runtLevel, &QSlider::sliderReleased, this, [this]{
+		emit triggerLevelPressed(false);
+	});
+
 	connect(triggerResetButton, &QCheckBox::clicked, this, [this]{
 		triggerLevel->setValue(0);
 		triggerTolerance->setValue(10);
 		slopeDial->setValue(1.0);
+		triggerHoldoff->setValue(0.0);
+		runtLevel->setValue(16384);
 
 		sweepParameters.triggerLevel = 0.0;
 		sweepParameters.triggerTolerance = 0.01;
 		sweepParameters.slope = 1.0;
+		sweepParameters.triggerHoldoff_ms = 0.0;
+		sweepParameters.runtLevel = 0.5;
 
 		QTimer::singleShot(150, this, [this]{
 			triggerResetButton->setChecked(false);
@@ -175,6 +297,130 @@ SweepSettingsWidget::SweepSettingsWidget(QWidget *parent)
 		setSlopeLabel(v);
 		emit sweepParametersChanged(sweepParameters);
 	});
+
+	updateTriggerControls();
+	populateTraces();
+}
+
+void SweepSettingsWidget::populateTriggerSources()
+{
+	triggerSourceSelector->clear();
+	for (int ch = 0; ch < sweepParameters.inputChannels; ch++) {
+		triggerSourceSelector->addItem(QStringLiteral("Ch %1").arg(ch), ch);
+	}
+
+	if (sweepParameters.inputChannels >= 2) {
+		triggerSourceSelector->addItem("Mid", TriggerSourceMid);
+		triggerSourceSelector->addItem("Side", TriggerSourceSide);
+	}
+
+	triggerSourceSelector->setCurrentIndex(std::max(0, triggerSourceSelector->findData(sweepParameters.triggerSource)));
+}
+
+void SweepSettingsWidget::populateTraces()
+{
+	// one row per channel : show, offset, scale, colour
+	const int numChannels = sweepParameters.inputChannels;
+	for (int ch = static_cast<int>(sweepParameters.traces.size()); ch < numChannels; ch++) {
+		sweepParameters.traces.append(sweepParameters.getTrace(ch));
+	}
+
+	if (numChannels == traceControlsChannels) {
+		return;
+	}
+
+	delete traceControls;
+	traceControls = new QWidget;
+	traceControlsChannels = numChannels;
+	auto tracesLayout = new QGridLayout;
+	tracesLayout->setContentsMargins(0, 0, 0, 0);
+	tracesLayout->addWidget(new QLabel("Offset"), 0, 1);
+	tracesLayout->addWidget(new QLabel("Scale"), 0, 2);
+	tracesLayout->addWidget(new QLabel("Colour"), 0, 3);
+
+	static const QVector<QPair<QString, QColor>> colors {
+		{"Phosphor", QColor{}},
+		{"Cyan", QColor{0x40, 0xe0, 0xff}},
+		{"Magenta", QColor{0xff, 0x60, 0xe0}},
+		{"Yellow", QColor{0xff, 0xe0, 0x40}},
+		{"Red", QColor{0xff, 0x40, 0x40}},
+		{"Blue", QColor{0x40, 0x60, 0xff}},
+		{"White", QColor{0xff, 0xff, 0xff}}
+	};
+
+	for (int ch = 0; ch < numChannels; ch++) {
+		const TraceParameters &trace = sweepParameters.traces.at(ch);
+
+		auto visible = new QCheckBox(QStringLiteral("Ch %1").arg(ch));
+		visible->setChecked(trace.visible);
+
+		auto offset = new QSlider;
+		offset->setToolTip("Vertical position of the trace's zero");
+		offset->setOrientation(Qt::Orientation::Horizontal);
+		offset->setRange(-100, 100);
+		offset->setValue(static_cast<int>(std::lround(100.0 * trace.offset)));
+
+		auto scale = new QDoubleSpinBox;
+		scale->setRange(0.1, 10.0);
+		scale->setSingleStep(0.1);
+		scale->setDecimals(1);
+		scale->setSuffix(" x");
+		scale->setValue(trace.scale);
+
+		auto color = new QComboBox;
+		for (const auto &c : colors) {
+			color->addItem(c.first, c.second);
+			if (c.second == trace.color) {
+				color->setCurrentIndex(color->count() - 1);
+			}
+		}
+
+		tracesLayout->addWidget(visible, ch + 1, 0);
+		tracesLayout->addWidget(offset, ch + 1, 1);
+		tracesLayout->addWidget(scale, ch + 1, 2);
+		tracesLayout->addWidget(color, ch + 1, 3);
+
+		connect(visible, &QCheckBox::toggled, this, [this, ch](bool checked){
+			sweepParameters.traces[ch].visible = checked;
+			emit sweepParametersChanged(sweepParameters);
+		});
+
+		connect(offset, &QSlider::valueChanged, this, [this, ch](int value){
+			sweepParameters.traces[ch].offset = 0.01 * value;
+			emit sweepParametersChanged(sweepParameters);
+		});
+
+		connect(scale, &QDoubleSpinBox::valueChanged, this, [this, ch](double value){
+			sweepParameters.traces[ch].scale = value;
+			emit sweepParametersChanged(sweepParameters);
+		});
+
+		connect(color, QOverload<int>::of(&QComboBox::activated), this, [this, ch, color]{
+			sweepParameters.traces[ch].color = color->currentData().value<QColor>();
+			emit sweepParametersChanged(sweepParameters);
+		});
+	}
+
+	traceControls->setLayout(tracesLayout);
+	tracesBox->layout()->addWidget(traceControls);
+}
+
+void SweepSettingsWidget::updateTriggerControls()
+{
+	const bool enabled = sweepParameters.triggerEnabled;
+	const TriggerMode mode = sweepParameters.triggerMode;
+	triggerResetButton->setEnabled(enabled);
+	triggerLevel->setEnabled(enabled);
+	triggerTolerance->setEnabled(enabled);
+	slopeDial->setEnabled(enabled);
+	triggerModeSelector->setEnabled(enabled);
+	triggerSourceSelector->setEnabled(enabled);
+	pulseWidthMin->setEnabled(enabled && mode == PulseWidthTrigger);
+	pulseWidthMax->setEnabled(enabled && mode == PulseWidthTrigger);
+	runtLevel->setEnabled(enabled && mode == RuntTrigger);
+
+	// (outside of Window mode, the tolerance is the width of the hysteresis band)
+	triggerToleranceLabel->setText(mode == WindowTrigger ? "Tolerance" : "Hysteresis");
 }
 
 void SweepSettingsWidget::initSweepRateMap()
@@ -204,6 +450,10 @@ void SweepSettingsWidget::setSweepParameters(const SweepParameters &newSweepPara
 
 	//triggerEnabled->setChecked(!sweepParameters.sweepUnused);
 
+	populateTriggerSources();
+	sweepParameters.triggerSource = triggerSourceSelector->currentData().toInt();
+	updateTriggerControls();
+	populateTraces();
 	setSweepParametersText();
 }
 
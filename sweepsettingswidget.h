@@ -4,7 +4,10 @@
 #include "sweepparameters.h"
 
 #include <QCheckBox>
+#include <QComboBox>
 #include <QDial>
+#include <QDoubleSpinBox>
+#include <QGroupBox>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMap>
@@ -14,6 +17,8 @@
 #include <QTextEdit>
 #include <QWidget>
 
+Q_DECLARE_METATYPE(TriggerMode)
+
 class SweepSettingsWidget : public QWidget
 {
 	Q_OBJECT
@@ -27,19 +32,36 @@ public:
 signals:
 	void sweepParametersChanged(const SweepParameters& sweepParameters);
 	void triggerLevelPressed(bool isPressed);
+	void triggerPositionPressed(bool isPressed);
 
 private:
 	QMap<int, double> sweepRateMap;
 
 	QSlider *sweepDial{nullptr};
 	QLabel *sweepInfo{nullptr};
+	QSlider *triggerPosition{nullptr};
+	QLabel *triggerPositionLabel{nullptr};
+	QCheckBox *envelopeRms{nullptr};
 	QSlider *triggerLevel{nullptr};
 	QSlider *triggerTolerance{nullptr};
 	QCheckBox *triggerEnabled{nullptr};
 	QCheckBox *triggerResetButton{nullptr};
 	QDial *slopeDial{nullptr};
+	QLabel *triggerToleranceLabel{nullptr};
+	QComboBox *triggerModeSelector{nullptr};
+	QComboBox *triggerSourceSelector{nullptr};
+	QDoubleSpinBox *triggerHoldoff{nullptr};
+	QDoubleSpinBox *pulseWidthMin{nullptr};
+	QDoubleSpinBox *pulseWidthMax{nullptr};
+	QSlider *runtLevel{nullptr};
+	QGroupBox *tracesBox{nullptr};
+	QWidget *traceControls{nullptr};
+	int traceControlsChannels{-1}; // (number of channels traceControls was made for)
 
 	void initSweepRateMap();
+	void populateTriggerSources();
+	void updateTriggerControls();
+	void populateTraces();
 
 	SweepParameters sweepParameters;
 	void setSweepParametersText();
@@ -0,0 +1,374 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "triggerengine.h"
+
+#include "cpufeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef SNDSCOPE_SSE2
+#include <immintrin.h>
+#endif
+
+// differentiator taps : {c0, 0, c2, 0, c4, 0, -c4, 0, -c2, 0, -c0}
+static constexpr float c0 = 0.0209f;
+static constexpr float c2 = -0.1128f;
+static constexpr float c4 = 1.2411f;
+
+// Window search : x[n] is the newest sample for frame n (x[n - 10] .. x[n - 1] are always valid)
+using WindowFunction = int64_t (*)(const float *x, int64_t from, int64_t to, float levelMin, float levelMax);
+
+// crossing search : first n in [from, to) with x[n] < lo, or x[n] >= hi
+using OutsideFunction = int64_t (*)(const float *x, int64_t from, int64_t to, float lo, float hi);
+
+static inline float slopeAt(const float *x, int64_t n)
+{
+	return c0 * (x[n] - x[n - 10]) + c2 * (x[n - 2] - x[n - 8]) + c4 * (x[n - 4] - x[n - 6]);
+}
+
+static inline int lowestBit(int mask)
+{
+	int b = 0;
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		b++;
+	}
+	return b;
+}
+
+static int64_t findWindowScalar(const float *x, int64_t from, int64_t to, float levelMin, float levelMax)
+{
+	for (int64_t n = from; n < to; n++) {
+		const float d = x[n - TriggerEngine::delayTime];
+		if (levelMin <= d && d <= levelMax && slopeAt(x, n) > 0.0f) {
+			return n;
+		}
+	}
+	return to;
+}
+
+static int64_t findOutsideScalar(const float *x, int64_t from, int64_t to, float lo, float hi)
+{
+	for (int64_t n = from; n < to; n++) {
+		if (x[n] < lo || x[n] >= hi) {
+			return n;
+		}
+	}
+	return to;
+}
+
+#ifdef SNDSCOPE_SSE2
+
+static int64_t findWindowSSE2(const float *x, int64_t from, int64_t to, float levelMin, float levelMax)
+{
+	const __m128 wMin = _mm_set1_ps(levelMin);
+	const __m128 wMax = _mm_set1_ps(levelMax);
+	const __m128 k0 = _mm_set1_ps(c0);
+	const __m128 k2 = _mm_set1_ps(c2);
+	const __m128 k4 = _mm_set1_ps(c4);
+
+	int64_t n = from;
+	for (; n + 4 <= to; n += 4) {
+		const __m128 d = _mm_loadu_ps(x + n - TriggerEngine::delayTime);
+		const __m128 inWindow = _mm_and_ps(_mm_cmpge_ps(d, wMin), _mm_cmple_ps(d, wMax));
+		if (_mm_movemask_ps(inWindow) == 0) {
+			continue;
+		}
+
+		// (same order of operations as slopeAt(), so that all implementations agree exactly)
+		const __m128 slope = _mm_add_ps(_mm_add_ps(
+											_mm_mul_ps(k0, _mm_sub_ps(_mm_loadu_ps(x + n), _mm_loadu_ps(x + n - 10))),
+											_mm_mul_ps(k2, _mm_sub_ps(_mm_loadu_ps(x + n - 2), _mm_loadu_ps(x + n - 8)))),
+										_mm_mul_ps(k4, _mm_sub_ps(_mm_loadu_ps(x + n - 4), _mm_loadu_ps(x + n - 6))));
+		const int mask = _mm_movemask_ps(_mm_and_ps(inWindow, _mm_cmpgt_ps(slope, _mm_setzero_ps())));
+		if (mask != 0) {
+			return n + lowestBit(mask);
+		}
+	}
+	return findWindowScalar(x, n, to, levelMin, levelMax);
+}
+
+static int64_t findOutsideSSE2(const float *x, int64_t from, int64_t to, float lo, float hi)
+{
+	const __m128 vLo = _mm_set1_ps(lo);
+	const __m128 vHi = _mm_set1_ps(hi);
+
+	int64_t n = from;
+	for (; n + 4 <= to; n += 4) {
+		const __m128 v = _mm_loadu_ps(x + n);
+		const int mask = _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(v, vLo), _mm_cmpge_ps(v, vHi)));
+		if (mask != 0) {
+			return n + lowestBit(mask);
+		}
+	}
+	return findOutsideScalar(x, n, to, lo, hi);
+}
+
+#endif // SNDSCOPE_SSE2
+
+#ifdef SNDSCOPE_AVX2
+
+SNDSCOPE_TARGET("avx2")
+static int64_t findWindowAVX2(const float *x, int64_t from, int64_t to, float levelMin, float levelMax)
+{
+	const __m256 wMin = _mm256_set1_ps(levelMin);
+	const __m256 wMax = _mm256_set1_ps(levelMax);
+	const __m256 k0 = _mm256_set1_ps(c0);
+	const __m256 k2 = _mm256_set1_ps(c2);
+	const __m256 k4 = _mm256_set1_ps(c4);
+
+	int64_t n = from;
+	for (; n + 8 <= to; n += 8) {
+		const __m256 d = _mm256_loadu_ps(x + n - TriggerEngine::delayTime);
+		const __m256 inWindow = _mm256_and_ps(_mm256_cmp_ps(d, wMin, _CMP_GE_OQ), _mm256_cmp_ps(d, wMax, _CMP_LE_OQ));
+		if (_mm256_movemask_ps(inWindow) == 0) {
+			continue;
+		}
+
+		const __m256 slope = _mm256_add_ps(_mm256_add_ps(
+											   _mm256_mul_ps(k0, _mm256_sub_ps(_mm256_loadu_ps(x + n), _mm256_loadu_ps(x + n - 10))),
+											   _mm256_mul_ps(k2, _mm256_sub_ps(_mm256_loadu_ps(x + n - 2), _mm256_loadu_ps(x + n - 8)))),
+										   _mm256_mul_ps(k4, _mm256_sub_ps(_mm256_loadu_ps(x + n - 4), _mm256_loadu_ps(x + n - 6))));
+		const __m256 rising = _mm256_cmp_ps(slope, _mm256_setzero_ps(), _CMP_GT_OQ);
+		const int mask = _mm256_movemask_ps(_mm256_and_ps(inWindow, rising));
+		if (mask != 0) {
+			return n + lowestBit(mask);
+		}
+	}
+	return findWindowSSE2(x, n, to, levelMin, levelMax);
+}
+
+SNDSCOPE_TARGET("avx2")
+static int64_t findOutsideAVX2(const float *x, int64_t from, int64_t to, float lo, float hi)
+{
+	const __m256 vLo = _mm256_set1_ps(lo);
+	const __m256 vHi = _mm256_set1_ps(hi);
+
+	// 2 vectors at a time
+	int64_t n = from;
+	for (; n + 16 <= to; n += 16) {
+		const __m256 v0 = _mm256_loadu_ps(x + n);
+		const __m256 v1 = _mm256_loadu_ps(x + n + 8);
+		const __m256 out0 = _mm256_or_ps(_mm256_cmp_ps(v0, vLo, _CMP_LT_OQ), _mm256_cmp_ps(v0, vHi, _CMP_GE_OQ));
+		const __m256 out1 = _mm256_or_ps(_mm256_cmp_ps(v1, vLo, _CMP_LT_OQ), _mm256_cmp_ps(v1, vHi, _CMP_GE_OQ));
+		const int mask = _mm256_movemask_ps(out0) | (_mm256_movemask_ps(out1) << 8);
+		if (mask != 0) {
+			return n + lowestBit(mask);
+		}
+	}
+	return findOutsideSSE2(x, n, to, lo, hi);
+}
+
+#endif // SNDSCOPE_AVX2
+
+struct SearchImplementation
+{
+	WindowFunction findWindow;
+	OutsideFunction findOutside;
+	const char *name;
+};
+
+static const SearchImplementation &getImplementation()
+{
+	// (see CpuFeatures::select())
+	static const SearchImplementation implementation = CpuFeatures::select<SearchImplementation>(
+		{findWindowScalar, findOutsideScalar, "scalar"},
+		SNDSCOPE_SSE2_IMPLEMENTATION(SearchImplementation{findWindowSSE2, findOutsideSSE2, "SSE2"}),
+		SNDSCOPE_AVX2_IMPLEMENTATION(SearchImplementation{findWindowAVX2, findOutsideAVX2, "AVX2"}));
+	return implementation;
+}
+
+TriggerEngine::TriggerEngine()
+{
+	reset();
+}
+
+void TriggerEngine::reset()
+{
+	source.assign(historyLength, 0.0f);
+	for (auto &history : channelHistory) {
+		history.assign(historyLength, 0.0f);
+	}
+	frames = 0ll;
+	blockStart = 0ll;
+	position = 0ll;
+	state = Unknown;
+	reachedRuntLevel = true;
+	pulseStartSeen = false;
+	updateThresholds();
+}
+
+void TriggerEngine::setSettings(const Settings &newSettings)
+{
+	// keep the history in step with a change of polarity (negation is exact)
+	if ((newSettings.slope < 0.0) != (settings.slope < 0.0)) {
+		for (float &s : source) {
+			s = -s;
+		}
+	}
+
+	settings = newSettings;
+	state = Unknown;
+	reachedRuntLevel = true;
+	pulseStartSeen = false;
+	updateThresholds();
+}
+
+TriggerEngine::Settings TriggerEngine::getSettings() const
+{
+	return settings;
+}
+
+void TriggerEngine::updateThresholds()
+{
+	const double polarity = (settings.slope < 0.0) ? -1.0 : 1.0;
+	const double level = polarity * settings.level;
+	const double tolerance = std::abs(settings.tolerance);
+	windowMin = static_cast<float>(level - tolerance);
+	windowMax = static_cast<float>(level + tolerance);
+	highThreshold = static_cast<float>(level);
+	lowThreshold = static_cast<float>(level - tolerance);
+	runtThreshold = static_cast<float>(polarity * settings.runtLevel);
+}
+
+void TriggerEngine::keepHistory(std::vector<float> &buffer, int64_t previousFrames, int64_t numFrames)
+{
+	// move the tail of the previous block to the front (capacity is kept, so this doesn't allocate once warmed-up)
+	std::copy(buffer.begin() + previousFrames, buffer.begin() + previousFrames + historyLength, buffer.begin());
+	buffer.resize(static_cast<size_t>(historyLength + numFrames));
+}
+
+void TriggerEngine::setInput(const float *const *channels, int numChannels, int64_t numFrames)
+{
+	int64_t channelFrames = frames;
+	if (static_cast<int>(channelHistory.size()) != numChannels) {
+		channelHistory.assign(static_cast<size_t>(numChannels), std::vector<float>(historyLength, 0.0f));
+		channelFrames = 0ll;
+	}
+
+	for (int ch = 0; ch < numChannels; ch++) {
+		std::vector<float> &history = channelHistory[static_cast<size_t>(ch)];
+		keepHistory(history, channelFrames, numFrames);
+		std::copy(channels[ch], channels[ch] + numFrames, history.begin() + historyLength);
+	}
+
+	// form the trigger source
+	keepHistory(source, frames, numFrames);
+	const float polarity = (settings.slope < 0.0) ? -1.0f : 1.0f;
+	const int lastChannel = numChannels - 1;
+	float *s = source.data() + historyLength;
+	if (settings.source == TriggerSourceMid || settings.source == TriggerSourceSide) {
+		// (mono : mid is ch0, and side is silence)
+		const float *a = channels[0];
+		const float *b = channels[std::min(1, lastChannel)];
+		const float ka = 0.5f * polarity;
+		const float kb = (settings.source == TriggerSourceMid) ? ka : -ka;
+		for (int64_t i = 0; i < numFrames; i++) {
+			s[i] = ka * a[i] + kb * b[i];
+		}
+	} else {
+		const float *a = channels[std::clamp(settings.source, 0, lastChannel)];
+		for (int64_t i = 0; i < numFrames; i++) {
+			s[i] = polarity * a[i];
+		}
+	}
+
+	blockStart += frames;
+	frames = numFrames;
+	position = 0ll;
+}
+
+int64_t TriggerEngine::findTrigger(int64_t from)
+{
+	const SearchImplementation &search = getImplementation();
+
+	if (settings.mode == WindowTrigger) {
+		// (stateless)
+		return (from >= frames) ? frames : search.findWindow(source.data() + historyLength, from, frames, windowMin, windowMax);
+	}
+
+	constexpr float infinity = std::numeric_limits<float>::infinity();
+	const float *x = source.data() + historyLength - delayTime; // (x[i] : the sample that frame i is decided on)
+
+	while (position < frames) {
+		if (state == Unknown) {
+			// (after a reset, the first delayTime samples are the history's silence, not signal)
+			const int64_t start = std::max(position, std::min<int64_t>(frames, delayTime - blockStart));
+			const int64_t i = search.findOutside(x, start, frames, lowThreshold, highThreshold);
+			position = std::min(i + 1, frames);
+			if (i == frames) {
+				break;
+			}
+
+			// found the signal on one side of the band : the next crossing is a genuine edge
+			// (if high, the pulse in progress began before it was seen, so it has no measurable width, and isn't a runt)
+			state = (x[i] < lowThreshold) ? Low : High;
+
+		} else if (state == Low) {
+			const int64_t i = search.findOutside(x, position, frames, -infinity, highThreshold);
+			position = std::min(i + 1, frames);
+			if (i == frames) {
+				break;
+			}
+
+			// gone high
+			state = High;
+			pulseStart = blockStart + i;
+			pulseStartSeen = true;
+			reachedRuntLevel = false;
+			if (settings.mode == EdgeTrigger && i >= from) {
+				return i;
+			}
+
+		} else {
+			const bool watchRunt = (settings.mode == RuntTrigger && !reachedRuntLevel);
+			const int64_t i = search.findOutside(x, position, frames, lowThreshold, watchRunt ? runtThreshold : infinity);
+			position = std::min(i + 1, frames);
+			if (i == frames) {
+				break;
+			}
+
+			if (x[i] >= lowThreshold) {
+				reachedRuntLevel = true;
+				continue;
+			}
+
+			// gone low : end of pulse
+			state = Low;
+			bool triggered = false;
+			if (settings.mode == PulseWidthTrigger && pulseStartSeen) {
+				const int64_t width = blockStart + i - pulseStart;
+				triggered = (width >= settings.minPulseWidth) && (settings.maxPulseWidth <= 0 || width <= settings.maxPulseWidth);
+			} else if (settings.mode == RuntTrigger) {
+				triggered = !reachedRuntLevel;
+			}
+
+			if (triggered && i >= from) {
+				return i;
+			}
+		}
+	}
+
+	return frames;
+}
+
+void TriggerEngine::finishBlock()
+{
+	if (settings.mode != WindowTrigger) {
+		findTrigger(frames);
+	}
+}
+
+const char *TriggerEngine::implementation()
+{
+	return getImplementation().name;
+}
@@ -0,0 +1,122 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef TRIGGERENGINE_H
+#define TRIGGERENGINE_H
+
+#include "triggermode.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// TriggerEngine : finds trigger points in whole blocks of samples.
+// The trigger source (a channel, or mid / side) is formed once per block, with its polarity flipped for
+// falling-slope triggers, so that every mode only ever has to look for rising signals.
+
+// Window : the source lies within [level - tolerance, level + tolerance], and the slope (from an 11-tap
+// differentiator centred on the sample) is positive. The differentiator is antisymmetric, with every second tap
+// zero, so it boils down to 3 multiplies; the window is tested first (which most samples fail), several at a time.
+// Edge, Pulse Width and Runt : driven by threshold crossings, with hysteresis. The source goes "high" when it reaches
+// the level, and "low" when it falls below level - tolerance.
+// Edge triggers on going high, Pulse Width on going low after being high for between min and max pulse widths,
+// and Runt on going low without having reached the runt level.
+// Crossings are found several samples at a time, so the cost is per block, plus a little per crossing.
+
+// Since the differentiator is centred, decisions (and the samples to plot) lag the input by delayTime samples.
+// The engine keeps the last few samples of each block, so that the next block carries on seamlessly,
+// and so that the state of a trigger (eg a pulse in progress) carries across blocks.
+// The best search implementation for the CPU is selected at run-time
+
+class TriggerEngine
+{
+public:
+	static constexpr int delayTime = 5; // (samples)
+
+	struct Settings
+	{
+		TriggerMode mode{WindowTrigger};
+		int source{0}; // channel, or TriggerSourceMid / TriggerSourceSide
+		double level{0.0};
+		double tolerance{0.01}; // (Window : half-width of window; otherwise hysteresis)
+		double slope{1.0}; // (+1 : rising, -1 : falling)
+		double runtLevel{0.5}; // (Runt : a pulse reaching this level is not a runt)
+		int64_t minPulseWidth{0ll}; // (Pulse Width, in frames)
+		int64_t maxPulseWidth{0ll}; // (Pulse Width, in frames; 0 : no maximum)
+	};
+
+	TriggerEngine();
+	void reset();
+
+	// changing the settings restarts the trigger (but keeps the history)
+	void setSettings(const Settings &newSettings);
+	Settings getSettings() const;
+
+	// start a new block (the previous block's tail is kept as history)
+	void setInput(const float *const *channels, int numChannels, int64_t numFrames);
+
+	// index of first trigger in [from, frames) of the current block (frames, if none).
+	// Samples before from are still watched (eg for the start of a pulse), but cannot trigger.
+	// Calls within a block must not go backwards.
+	int64_t findTrigger(int64_t from);
+
+	// watch the rest of the block (without triggering)
+	void finishBlock();
+
+	// the sample of a channel that goes with the trigger decision for frame i
+	float delayed(int ch, int64_t i) const
+	{
+		return delayedChannel(ch)[i];
+	}
+
+	// (as above, for the whole block : [0, frames) are valid)
+	const float *delayedChannel(int ch) const
+	{
+		return channelHistory[static_cast<size_t>(ch)].data() + historyLength - delayTime;
+	}
+
+	static const char *implementation();
+
+private:
+	static constexpr int historyLength = 10; // (differentiator taps - 1)
+
+	enum State
+	{
+		Unknown, // (not yet seen beyond the hysteresis band)
+		Low,
+		High
+	};
+
+	Settings settings;
+
+	// each buffer holds historyLength samples from previous blocks, followed by the current block
+	std::vector<float> source; // (polarity-adjusted)
+	std::vector<std::vector<float>> channelHistory;
+	int64_t frames{0ll};
+	int64_t blockStart{0ll}; // frames since reset, at start of current block
+
+	// crossing detector
+	int64_t position{0ll}; // (next frame to examine)
+	State state{Unknown}; // (nothing triggers until the signal has been seen on one side of the band, then crossed it)
+	bool reachedRuntLevel{true};
+	bool pulseStartSeen{false}; // (pulseStart is only known once the signal has been seen to go high)
+	int64_t pulseStart{0ll};
+
+	// (thresholds, in polarity-adjusted terms)
+	float windowMin{0.0f};
+	float windowMax{0.0f};
+	float highThreshold{0.0f};
+	float lowThreshold{0.0f};
+	float runtThreshold{0.0f};
+
+	void updateThresholds();
+	static void keepHistory(std::vector<float> &buffer, int64_t previousFrames, int64_t numFrames);
+};
+
+#endif // TRIGGERENGINE_H
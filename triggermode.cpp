@@ -0,0 +1,14 @@
+#include "triggermode.h"
+
+QMap<TriggerMode, TriggerModeDefinition> TriggerModeManager::triggerModeMap
+{
+	{WindowTrigger, {WindowTrigger, "Window", "Level ± Tolerance, on the chosen slope"}},
+	{EdgeTrigger, {EdgeTrigger, "Edge", "Crossing the Level, after first going beyond the Hysteresis band"}},
+	{PulseWidthTrigger, {PulseWidthTrigger, "Pulse Width", "End of a pulse (beyond the Level) lasting between the Min and Max widths"}},
+	{RuntTrigger, {RuntTrigger, "Runt", "End of a pulse that crosses the Level, but not the Runt Level"}}
+};
+
+const QMap<TriggerMode, TriggerModeDefinition>& TriggerModeManager::getTriggerModeMap()
+{
+	return triggerModeMap;
+}
@@ -0,0 +1,37 @@
+#ifndef TRIGGERMODE_H
+#define TRIGGERMODE_H
+
+#include <QMap>
+#include <QString>
+
+enum TriggerMode
+{
+	WindowTrigger,
+	EdgeTrigger,
+	PulseWidthTrigger,
+	RuntTrigger
+};
+
+// trigger source : a channel number (0, 1, ...), or a combination of channels 0 and 1
+enum TriggerSource
+{
+	TriggerSourceMid = -1, // (ch0 + ch1) / 2
+	TriggerSourceSide = -2 // (ch0 - ch1) / 2
+};
+
+struct TriggerModeDefinition
+{
+	TriggerMode triggerMode;
+	QString name;
+	QString description;
+};
+
+class TriggerModeManager
+{
+	static QMap<TriggerMode, TriggerModeDefinition> triggerModeMap;
+
+public:
+	static const QMap<TriggerMode, TriggerModeDefinition>& getTriggerModeMap();
+};
+
+#endif // TRIGGERMODE_H
@@ -0,0 +1,73 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "upsampler.h"
+
+// filter bank (all designed at compile time)
+template<int L>
+static constexpr auto upsamplerDesign = Polyphase::design<L>(UpsamplerPrototype<L>::coeffs);
+
+template<int L>
+static constexpr Polyphase::Filter upsamplerFilter = upsamplerDesign<L>.filter();
+
+const Polyphase::Filter &UpsampleFactors::filter(int L)
+{
+	if (L >= 16) {
+		return upsamplerFilter<16>;
+	}
+	if (L >= 8) {
+		return upsamplerFilter<8>;
+	}
+	if (L >= 6) {
+		return upsamplerFilter<6>;
+	}
+	if (L >= 4) {
+		return upsamplerFilter<4>;
+	}
+	if (L >= 3) {
+		return upsamplerFilter<3>;
+	}
+	if (L >= 2) {
+		return upsamplerFilter<2>;
+	}
+	return upsamplerFilter<1>;
+}
+
+int UpsampleFactors::maxFactor(int sampleRate)
+{
+	int m = 1;
+	for (int L : supported) {
+		if (static_cast<int64_t>(sampleRate) * L <= maxOutputRate) {
+			m = L;
+		}
+	}
+	return m;
+}
+
+int UpsampleFactors::forSweep(int sampleRate, double inputFramesPerSweep, int sweepWidth_pixels)
+{
+	const int m = maxFactor(sampleRate);
+	for (int L : supported) {
+		if (L >= m || inputFramesPerSweep * L >= targetSamplesPerPixel * sweepWidth_pixels) {
+			return std::min(L, m);
+		}
+	}
+	return m;
+}
+
+int UpsampleFactors::forXY(int sampleRate)
+{
+	const int m = maxFactor(sampleRate);
+	for (int L : supported) {
+		if (L >= m || static_cast<int64_t>(sampleRate) * L >= targetXYOutputRate) {
+			return std::min(L, m);
+		}
+	}
+	return m;
+}
@@ -18,202 +18,113 @@
 #include "functimer.h"
 #endif
 
+#include "filterdesign.h"
+#include "polyphase.h"
+
 #include <QDebug>
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <type_traits>
 #include <vector>
 
-template <typename InputType, typename OutputType, int L>
+// UpsamplerPrototype<L> : prototype (lowpass) filter for upsampling by a factor of L :
+// a Kaiser-windowed sinc, cut off at the Nyquist frequency of the input, spanning 2 * halfSpan input samples.
+// (Every L'th coefficient either side of the centre is zero, so the input samples themselves pass through unchanged)
+// These are designed, and decomposed into polyphase form (see Polyphase::design()), at compile time
+
+template<int L>
+struct UpsamplerPrototype
+{
+	static constexpr size_t halfSpan = 11;
+	static constexpr double kaiserBeta = 7.0; // (about 75dB stopband attenuation)
+	static constexpr auto coeffs = FilterDesign::kaiserLowpass<2 * halfSpan * L + 1>(0.5 / L, kaiserBeta);
+};
+
+template<>
+struct UpsamplerPrototype<1>
+{
+	static constexpr std::array<double, 1> coeffs {1.0};
+};
+
+// UpsampleFactors : the upsampling factors for which filters are available,
+// and choice of factor to suit the source material and the display
+
+struct UpsampleFactors
+{
+	static constexpr std::array<int, 7> supported {1, 2, 3, 4, 6, 8, 16};
+	static constexpr int maxOutputRate = 768000; // (limits CPU load for high sample rates)
+	static constexpr double targetSamplesPerPixel = 1.0; // for sweep mode
+	static constexpr int targetXYOutputRate = 176400; // for XY mode
+
+	// filter for largest supported factor <= L
+	static const Polyphase::Filter &filter(int L);
+
+	// largest factor allowed for a given sample rate
+	static int maxFactor(int sampleRate);
+
+	// smallest factor giving at least targetSamplesPerPixel across the sweep
+	static int forSweep(int sampleRate, double inputFramesPerSweep, int sweepWidth_pixels);
+
+	// smallest factor giving at least targetXYOutputRate
+	static int forXY(int sampleRate);
+};
+
+// UpSampler : polyphase interpolator for any number of channels, with upsampling factor selectable at run-time
+
+template <typename InputType, typename OutputType>
 class UpSampler
 {
 private:
-	static constexpr OutputType coeffs2[] {
-		-0.00087560000,
-		-0.0011643619,
-		0.0010874736,
-		0.0022780589,
-		-0.0035814886,
-		-0.0036865168,
-		0.0068853690,
-		0.027796547,
-		-0.11749555,
-		0.22353046,
-		0.72835886,
-		0.22353046,
-		-0.11749555,
-		0.027796547,
-		0.0068853690,
-		-0.0036865168,
-		-0.0035814886,
-		0.0022780589,
-		0.0010874736,
-		-0.0011643619,
-		-0.00087560000
-	};
-
-	// todo: design filters for other L - factors
-	static constexpr OutputType coeffs4[] { // Coeffs: 73
-		9.962570624126234e-06,
-		3.957986016501213e-05,
-		7.897128934649362e-05,
-		9.703385688654565e-05,
-		4.907628580966033e-05,
-		-9.745242907276185e-05,
-		-0.0003277460000285871,
-		-0.0005546006935996341,
-		-0.0006271869492189099,
-		-0.0003873942489772647,
-		0.0002360729907676491,
-		0.001134117122777654,
-		0.001980393734487934,
-		0.002299817644506438,
-		0.001652311950832638,
-		-0.000118129592931525,
-		-0.002674473313982637,
-		-0.005142797340279459,
-		-0.006319879497941102,
-		-0.005122599644451211,
-		-0.001147119917015838,
-		0.004890392747595472,
-		0.01107576602347318,
-		0.01473257464486369,
-		0.01333568444250735,
-		0.005648367147916558,
-		-0.007330649408092939,
-		-0.0220424891989685,
-		-0.03294052256597733,
-		-0.0339351609472972,
-		-0.02034506079624187,
-		0.009262557923020177,
-		0.0520089438641673,
-		0.1008883411385215,
-		0.146278561186415,
-		0.1784009001925697,
-		0.19,
-		0.1784009001925697,
-		0.146278561186415,
-		0.1008883411385215,
-		0.0520089438641673,
-		0.009262557923020177,
-		-0.02034506079624187,
-		-0.0339351609472972,
-		-0.03294052256597733,
-		-0.0220424891989685,
-		-0.007330649408092947,
-		0.005648367147916558,
-		0.01333568444250735,
-		0.01473257464486369,
-		0.01107576602347318,
-		0.004890392747595472,
-		-0.001147119917015838,
-		-0.005122599644451211,
-		-0.006319879497941102,
-		-0.005142797340279469,
-		-0.002674473313982637,
-		-0.000118129592931525,
-		0.001652311950832638,
-		0.002299817644506438,
-		0.001980393734487934,
-		0.001134117122777654,
-		0.000236072990767649,
-		-0.0003873942489772647,
-		-0.0006271869492189109,
-		-0.0005546006935996341,
-		-0.0003277460000285872,
-		-9.745242907276185e-05,
-		4.907628580966033e-05,
-		9.703385688654547e-05,
-		7.897128934649362e-05,
-		3.957986016501203e-05,
-		9.962570624126234e-06
-	};
+	const Polyphase::Filter *filter{nullptr};
+	int numChannels{0};
+	size_t channelHistoryLength{0};
+	std::vector<float> histories; // one after another (see Polyphase for layout)
+	std::vector<size_t> positions;
 
 public:
-	// FIR Filter
-	size_t fir_length;
-	std::vector<OutputType> fir_coeffs;
-	std::vector<OutputType> history0;
-	std::vector<OutputType> history1;
-
-	size_t index;
-	size_t n;
-
 	UpSampler()
-    {
-		switch (L) {
-		case 1:
-			break;
-		case 2:
-			setCoefficients(coeffs2);
-			break;
-		case 4:
-			setCoefficients(coeffs4);
-			break;
-		default:
-			setCoefficients(coeffs4);
-			// caller must supply own coefficients (by calling setCoefficients( ...)
-			break;
-		}
+	{
+		setFactor(1);
+		setNumChannels(2);
 	}
 
-	// set coeffs from native array
-	template<size_t Array_Length>
-	void setCoefficients(const OutputType (&array)[Array_Length])
+	// setFactor() and setNumChannels() allocate, if more history is needed than before
+
+	void setFactor(int L)
 	{
-		setCoefficients(array, Array_Length);
+		filter = &UpsampleFactors::filter(L);
+		allocate();
 	}
 
-	// set coeffs from pointer + count
-	void setCoefficients(const OutputType* firCoeffs, size_t count)
+	void setNumChannels(int newNumChannels)
 	{
-		fir_length = count;
-
-		fir_coeffs.clear();
-		for (size_t i = 0; i < count; i++) {
-			fir_coeffs.push_back(L * firCoeffs[i]);
-		}
-
-		n = 1 + fir_length / L;
-
-		// add padding
-		size_t r = n * L - fir_length;
-		for (size_t i = 0; i < r; i++) {
-			fir_coeffs.push_back(0.0);
-		}
-
-		history0.resize(fir_length, 0.0);
-		history1.resize(fir_length, 0.0);
-		index = fir_length - 1;
+		numChannels = newNumChannels;
+		allocate();
 	}
 
-	void reset()
+	// actual factor in use (the largest supported factor <= the one requested)
+	int getFactor() const
 	{
-		std::fill(history0.begin(), history0.end(), 0.0);
-		std::fill(history1.begin(), history1.end(), 0.0);
-		index = fir_length - 1;
+		return filter->L;
 	}
 
-	void upsampleBlockMono(OutputType* output, const InputType* input, size_t sampleCount)
+	int getNumChannels() const
 	{
-		for (size_t s = 0; s < sampleCount; s++) {
-			upsampleSingleMono(output, *input++);
-			output += L;
-		}
+		return numChannels;
 	}
 
-	void upsampleBlockStereo(OutputType* output0, OutputType* output1, const InputType* interleaved, size_t sampleCount)
+	void reset()
 	{
-		for (size_t s = 0; s < sampleCount; s ++) {
-			upsampleSingleStereo(output0, output1, *interleaved, *(interleaved + 1));
-			interleaved += 2;
-			output0 += L;
-			output1 += L;
-		}
+		std::fill(histories.begin(), histories.end(), 0.0f);
+		std::fill(positions.begin(), positions.end(), filter->taps);
 	}
 
-	inline void upsampleSingleMono(OutputType* output, InputType input)
+	// de-interleave and upsample all channels : outputs has one pointer per channel,
+	// each with room for sampleCount * getFactor() samples
+	void upsampleBlock(OutputType* const* outputs, const InputType* interleaved, size_t sampleCount)
 	{
-
 #ifdef UPSAMPLER_TIME_FUNC
 		static double renderTime = 0.0;
 		FuncTimerQ funcTimer(&renderTime);
@@ -223,64 +134,57 @@ public:
 
 		const double mov_avg_renderTime = movingAverage.get(renderTime);
 
-		constexpr int64_t every = 10000;
+		constexpr int64_t every = 1000;
 		if (++callCount % every == 0) {
-			qDebug() << QStringLiteral("Avg Upsample time(last %1)=%2ns")
+			qDebug() << QStringLiteral("Avg Upsample time(last %1)=%2ns (%3, %4 channels)")
 						.arg(historyLength)
-						.arg(mov_avg_renderTime, 0, 'f', 2);
+						.arg(mov_avg_renderTime, 0, 'f', 2)
+						.arg(Polyphase::implementation(*filter))
+						.arg(numChannels);
 		}
 #endif
 
-		history0[index] = static_cast<OutputType>(input);
-		size_t p = index;
-
-		memset(output, 0.0, L * sizeof(OutputType));
-
-		for (size_t j = 0; j < n * L; j+= L) {
-			for (size_t k = 0; k < L; k++) {
-				output[k] += fir_coeffs[j+k] * history0[p];
-			}
-
-			if (++p == fir_length) {
-				p = 0;
-			}
-		}
-
-		if (index-- == 0) {
-			index = fir_length - 1;
+		for (int ch = 0; ch < numChannels; ch++) {
+			upsampleChannel(ch, outputs[ch], interleaved + ch, numChannels, sampleCount);
 		}
 	}
 
-	inline void upsampleSingleStereo(OutputType* output0, OutputType* output1, InputType input0, InputType input1)
+private:
+	void allocate()
 	{
-		history0[index] = static_cast<OutputType>(input0);
-		history1[index] = static_cast<OutputType>(input1);
-
-		size_t p = index;
-
-		memset(output0, 0.0, L * sizeof(OutputType));
-		memset(output1, 0.0, L * sizeof(OutputType));
-
-		for (size_t j = 0; j < n * L; j+= L) {
-			for (size_t k = 0; k < L; k++) {
-				output0[k] += fir_coeffs[j+k] * history0[p];
-				output1[k] += fir_coeffs[j+k] * history1[p];
-			}
+		channelHistoryLength = filter->historyLength();
+		histories.resize(numChannels * channelHistoryLength);
+		positions.resize(numChannels);
+		reset();
+	}
 
-			if (++p == fir_length) {
-				p = 0;
+	void upsampleChannel(int ch, OutputType* output, const InputType* input, size_t inputStride, size_t sampleCount)
+	{
+		float* history = histories.data() + ch * channelHistoryLength;
+		size_t& pos = positions[ch];
+
+		if constexpr (std::is_same_v<InputType, float> && std::is_same_v<OutputType, float>) {
+			Polyphase::upsample(output, input, inputStride, sampleCount, history, pos, *filter);
+		} else {
+			const size_t taps = filter->taps;
+			for (size_t s = 0; s < sampleCount; s++) {
+				if (pos == 0) {
+					std::copy_backward(history, history + taps - 1, history + 2 * taps);
+					pos = taps + 1;
+				}
+				history[--pos] = static_cast<float>(input[s * inputStride]);
+				const float* window = history + pos;
+				for (int k = 0; k < filter->L; k++) {
+					const float* c = filter->coeffs + k * taps;
+					float acc = 0.0f;
+					for (size_t i = 0; i < taps; i++) {
+						acc += window[i] * c[i];
+					}
+					*output++ = static_cast<OutputType>(acc);
+				}
 			}
 		}
-
-		if (index-- == 0) {
-			index = fir_length - 1;
-		}
 	}
-
-	size_t delayTime() const
-	{
-		return (fir_length - 1)  / 2;
-	};
 };
 
 #endif // UPSAMPLER_H
@@ -0,0 +1,111 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#include "workerpool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(int numWorkers)
+{
+	if (numWorkers <= 0) {
+		numWorkers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	// (worker 0 is the calling thread)
+	for (int worker = 1; worker < numWorkers; worker++) {
+		threads.emplace_back(&WorkerPool::workerLoop, this, worker);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	startCondition.notify_all();
+
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
+int WorkerPool::size() const
+{
+	return static_cast<int>(threads.size()) + 1;
+}
+
+void WorkerPool::run(int newNumTasks, const Task &task)
+{
+	if (newNumTasks <= 0) {
+		return;
+	}
+
+	// not worth waking anybody for a single task
+	if (threads.empty() || newNumTasks == 1) {
+		for (int t = 0; t < newNumTasks; t++) {
+			task(t, 0);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentTask = &task;
+		numTasks = newNumTasks;
+		nextTask.store(0, std::memory_order_relaxed);
+		busyWorkers = static_cast<int>(threads.size());
+		generation++;
+	}
+	startCondition.notify_all();
+
+	runTasks(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [this]{
+		return busyWorkers == 0;
+	});
+	currentTask = nullptr;
+}
+
+void WorkerPool::workerLoop(int worker)
+{
+	int64_t lastGeneration = 0ll;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startCondition.wait(lock, [this, lastGeneration]{
+				return quit || generation != lastGeneration;
+			});
+			if (quit) {
+				return;
+			}
+			lastGeneration = generation;
+		}
+
+		runTasks(worker);
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			last = (--busyWorkers == 0);
+		}
+		if (last) {
+			doneCondition.notify_one();
+		}
+	}
+}
+
+void WorkerPool::runTasks(int worker)
+{
+	for (int t = nextTask.fetch_add(1, std::memory_order_relaxed); t < numTasks;
+		 t = nextTask.fetch_add(1, std::memory_order_relaxed)) {
+		(*currentTask)(t, worker);
+	}
+}
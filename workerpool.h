@@ -0,0 +1,58 @@
+/*
+* Copyright (C) 2020 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/sndscope.git
+*/
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// WorkerPool : a set of persistent threads for running a batch of independent tasks in parallel.
+// Tasks are claimed one at a time from a shared atomic counter, so a worker that finishes early
+// simply takes the next unclaimed task (no task is ever pinned to a particular worker).
+// The calling thread takes part in the batch, and run() returns once every task has finished.
+// run() must not be called concurrently, or from within a task.
+
+class WorkerPool
+{
+public:
+	using Task = std::function<void(int task, int worker)>;
+
+	explicit WorkerPool(int numWorkers = 0); // number of workers including the caller (0 : one per hardware thread)
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+
+	int size() const;
+	void run(int numTasks, const Task &task);
+
+private:
+	std::vector<std::thread> threads;
+
+	std::mutex mutex;
+	std::condition_variable startCondition;
+	std::condition_variable doneCondition;
+	int64_t generation{0ll}; // incremented for each batch (guarded by mutex)
+	int busyWorkers{0}; // (guarded by mutex)
+	bool quit{false}; // (guarded by mutex)
+
+	const Task *currentTask{nullptr};
+	int numTasks{0};
+	std::atomic<int> nextTask{0};
+
+	void workerLoop(int worker);
+	void runTasks(int worker);
+};
+
+#endif // WORKERPOOL_H